@@ -0,0 +1,745 @@
+/** Mastermind Strategy Benchmark
+* @file: bench.c
+* @author Michael Reitgruber
+* @date 18.10.2026
+* @brief Offline benchmark for the client strategy
+* @details Plays the strategy against every possible secret without any sockets, scoring each guess with the
+*          server's compute_answer(). The games are cut into tasks of TASK_GAMES secrets of one strategy, which are
+*          dealt out to one worker thread per core; a worker out of tasks steals from the others. Every task keeps its
+*          own statistics, merged in task order when all are done, so the results do not depend on the scheduling.
+*          With -n only that many secrets, spread evenly over all codes, are played, with -R a random sample drawn
+*          with the seed given by -S, with -f the secrets listed in a file (one per line, a hex digit per pin);
+*          -v plays other numbers of pins and colors, scored like the server does in the wide encoding; -s selects
+*          the strategy of the solver and -O plays the best opening of a table written by the opening tool.
+*          Given a comma separated list of strategies, -s plays a tournament: every strategy plays every secret and
+*          a matrix of rounds and CPU time per strategy is printed.
+*          With -c the server's precomputed answer tables are checked against compute_answer() for every
+*          secret played.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "strategy.h"
+#include "rules.h"
+
+/*Maximum number of lost secrets which are remembered for the report*/
+#define MAX_LOST_REPORT (32)
+
+/*Number of games of one task*/
+#define TASK_GAMES (64)
+
+/*Largest number of strategies of a tournament*/
+#define MAX_STRATEGIES (8)
+
+//How the secrets played are chosen
+enum secret_set {SPREAD, SAMPLE, LISTED};
+
+//Statistics collected by one worker, merged by the parent
+struct stats {
+    long games;
+    long rounds;
+    int max_rounds;
+    long histogram[MAX_TRIES + 1];
+    long lost;
+    uint32_t lost_secrets[MAX_LOST_REPORT];
+    long table_errors;
+    long guess_calls;
+    long long guess_ns;
+    long long max_guess_ns;
+};
+
+//Games of one strategy against a range of secrets
+struct task {
+    int strategy;
+    long first;             //secrets first to last - 1 of the secret set
+    long last;
+    long long cpu_ns;
+    struct stats stats;
+};
+
+//One worker thread and the tasks dealt to it, run from the bottom and stolen from the top
+struct job {
+    pthread_t thread;
+    int id;
+    pthread_mutex_t lock;
+    long top;
+    long bottom;
+    long steals;
+};
+
+//name of the program
+static const char *progname = "bench";
+
+//whether to check the answer tables
+static int check_tables = 0;
+
+//the number of pins and colors
+static struct variant variant;
+
+//how the solvers choose their guesses, several for a tournament
+static enum solver_strategy strategies[MAX_STRATEGIES] = {STRATEGY_FIRST};
+static char *strategy_names[MAX_STRATEGIES] = {"first"};
+static int strategy_count = 1;
+
+//the secrets played: games of them, chosen as set tells
+static enum secret_set secret_set = SPREAD;
+static long games = 0;
+static uint32_t *listed = NULL;
+static uint64_t sample_mul = 1, sample_add = 0;
+
+//all tasks and the workers running them
+static struct task *tasks = NULL;
+static long task_count = 0;
+static struct job *job = NULL;
+static long jobs = 0;
+
+//the first guess, NULL for pairs of colors
+static int opening[MAX_PINS];
+static const int *start_guess = NULL;
+
+/**
+ * Credit to the OSUE-Team
+ * @brief terminate program on program error
+ * @param exitcode exit code
+ * @param fmt format string
+ */
+static void bail_out(int exitcode, const char *fmt, ...);
+
+/**
+ * @brief Prints correct usage of program to stderr
+ */
+static void usage(void);
+
+/**
+ * @brief Parses a positive integer
+ * @param string The string to be parsed
+ * @return The parsed integer, or -1 on failure
+ */
+static long parse_long(const char *string);
+
+/**
+ * @brief Current value of the monotonic clock
+ * @return Nanoseconds since an arbitrary point in time
+ */
+static long long now_ns(void);
+
+/**
+ * @brief Plays one game against the given secret
+ * @param secret Index of the secret (the pins in base colors, first pin is the least significant digit)
+ * @param strategy Index of the strategy to play
+ * @param st Statistics to update
+ */
+static void play_game(uint32_t secret, int strategy, struct stats *st);
+
+/**
+ * @brief Returns a secret of the secret set
+ * @param i Number of the secret, 0 to games - 1
+ * @return Index of the secret
+ */
+static uint32_t secret_at(long i);
+
+/**
+ * @brief Draws a random sample of secrets
+ * @detail The sample are the first secrets of a permutation i -> (mul * i + add) mod codes, with mul coprime to the
+ *         number of codes; mul and add are drawn from a splitmix64 generator seeded with seed
+ * @param seed The seed
+ */
+static void draw_sample(uint64_t seed);
+
+/**
+ * @brief Steps a splitmix64 generator
+ * @param state The state of the generator
+ * @return The next random number
+ */
+static uint64_t splitmix64(uint64_t *state);
+
+/**
+ * @brief Reads the secrets listed in a file
+ * @detail One secret per line with a hex digit per pin, first pin first; lines starting with # are skipped
+ * @param path The file
+ */
+static void load_secrets(const char *path);
+
+/**
+ * @brief Splits a comma separated list of strategies
+ * @param list The list, modified
+ */
+static void parse_strategies(char *list);
+
+/**
+ * @brief Takes the next task of a worker, stealing one from another worker if it has none left
+ * @param job The worker
+ * @return Index of the task, -1 if no task is left
+ */
+static long take_task(struct job *job);
+
+/**
+ * @brief Compares the answer table of a secret with compute_answer() for every possible request
+ * @param pins The secret
+ * @return Number of requests with differing answers
+ */
+static long check_table(const uint8_t *pins);
+
+/**
+ * @brief The procedure representing one worker thread
+ * @detail Runs tasks until none is left
+ * @param arg The job of the worker
+ * @return NULL
+ */
+static void *worker(void *arg);
+
+/**
+ * @brief Adds the statistics of one worker to the total
+ * @param total The merged statistics
+ * @param st The statistics of one worker
+ */
+static void merge(struct stats *total, const struct stats *st);
+
+/**
+ * @brief Prints the report
+ * @param st The merged statistics
+ * @param wall_ns Wall time of the whole run
+ * @param jobs Number of workers used
+ */
+static void report(const struct stats *st, long long wall_ns, int jobs);
+
+/**
+ * @brief Prints the results of a tournament, one row per strategy
+ * @param st The merged statistics of every strategy
+ * @param cpu_ns The CPU time of every strategy
+ * @param wall_ns Wall time of the whole run
+ */
+static void report_tournament(const struct stats *st, const long long *cpu_ns, long long wall_ns);
+
+/**
+ * @brief Main entry point, spawns the workers and collects their results
+ * @param argc Number of arguments passed to the program
+ * @param argv Array containing the passed arguments
+ * @return EXIT_SUCCESS if every game was won, EXIT_FAILURE on error, 3 if a game was lost
+ */
+int main(int argc, char *argv[])
+{
+    const char *openings = NULL;
+    const char *secrets_file = NULL;
+    uint64_t seed = 1;
+    long steals = 0;
+    int c;
+
+    if(argc > 0) {
+        progname = argv[0];
+    }
+    jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    (void) variant_init(&variant, SLOTS, COLORS);
+    while((c = getopt(argc, argv, "cf:j:n:O:R:s:S:v:")) != -1) {
+        switch(c) {
+        case 'c':
+            check_tables = 1;
+            break;
+        case 'f':
+            secrets_file = optarg;
+            break;
+        case 'j':
+            if((jobs = parse_long(optarg)) <= 0) {
+                bail_out(EXIT_FAILURE, "Argument for -j not a positive integer");
+            }
+            break;
+        case 'n':
+        case 'R':
+            if((games = parse_long(optarg)) <= 0) {
+                bail_out(EXIT_FAILURE, "Argument for -%c not a positive integer", c);
+            }
+            secret_set = c == 'R' ? SAMPLE : SPREAD;
+            break;
+        case 'O':
+            openings = optarg;
+            break;
+        case 's':
+            parse_strategies(optarg);
+            break;
+        case 'S':
+            errno = 0;
+            seed = strtoull(optarg, NULL, 0);
+            if(errno != 0) {
+                bail_out(EXIT_FAILURE, "Argument for -S not a number");
+            }
+            break;
+        case 'v':
+            if(parse_variant(optarg, &variant) == -1) {
+                bail_out(EXIT_FAILURE, "Argument for -v has to be <pins>x<colors>, at most %dx%d",
+                         MAX_SLOTS, MAX_COLORS);
+            }
+            break;
+        case '?':
+            usage();
+            return EXIT_FAILURE;
+        default: assert(0);
+        }
+    }
+    if(optind != argc) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    if(secrets_file != NULL) {
+        if(games != 0) {
+            bail_out(EXIT_FAILURE, "-f cannot be combined with -n or -R");
+        }
+        load_secrets(secrets_file);
+    }
+    if(games == 0) {
+        games = variant.codes;
+    }
+    if(games > variant.codes && secret_set != LISTED) {
+        bail_out(EXIT_FAILURE, "Argument for -n or -R has to be in 1-%lu", (unsigned long)variant.codes);
+    }
+    if(secret_set == SAMPLE) {
+        draw_sample(seed);
+    }
+    if(openings != NULL) {
+        if(load_opening(openings, variant.slots, variant.colors, opening) == -1) {
+            bail_out(EXIT_FAILURE, "Error loading an opening for %dx%d from %s", variant.slots, variant.colors,
+                     openings);
+        }
+        start_guess = opening;
+    }
+    if(check_tables && variant.wide) {
+        bail_out(EXIT_FAILURE, "Answer tables only exist for %dx%d", SLOTS, COLORS);
+    }
+
+    /* the tasks of a strategy follow each other */
+    long per_strategy = (games + TASK_GAMES - 1) / TASK_GAMES;
+    task_count = per_strategy * strategy_count;
+    if((tasks = calloc(task_count, sizeof *tasks)) == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating tasks");
+    }
+    for(long t=0; t<task_count; t++) {
+        tasks[t].strategy = t / per_strategy;
+        tasks[t].first = t % per_strategy * TASK_GAMES;
+        tasks[t].last = tasks[t].first + TASK_GAMES < games ? tasks[t].first + TASK_GAMES : games;
+    }
+    if(jobs < 1) {
+        jobs = 1;
+    }
+    if(jobs > task_count) {
+        jobs = task_count;
+    }
+
+    if(solver_stats_signal() == -1) {
+        bail_out(EXIT_FAILURE, "Error installing signal handler");
+    }
+    if((job = calloc(jobs, sizeof *job)) == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating workers");
+    }
+    long long start = now_ns();
+
+    /* deal out consecutive tasks; slow strategies are stolen from by the workers done early */
+    for(int i=0; i<jobs; i++) {
+        job[i].id = i;
+        job[i].top = task_count * i / jobs;
+        job[i].bottom = task_count * (i + 1) / jobs;
+        (void) pthread_mutex_init(&job[i].lock, NULL);
+    }
+    for(int i=0; i<jobs; i++) {
+        if((errno = pthread_create(&job[i].thread, NULL, worker, &job[i])) != 0) {
+            bail_out(EXIT_FAILURE, "Error starting worker");
+        }
+    }
+    for(int i=0; i<jobs; i++) {
+        (void) pthread_join(job[i].thread, NULL);
+        (void) pthread_mutex_destroy(&job[i].lock);
+        steals += job[i].steals;
+    }
+    free(job);
+    long long wall_ns = now_ns() - start;
+
+    struct stats total[MAX_STRATEGIES];
+    long long cpu_ns[MAX_STRATEGIES] = {0};
+    long lost = 0, table_errors = 0;
+    (void) memset(total, 0, sizeof total);
+    for(long t=0; t<task_count; t++) {
+        merge(&total[tasks[t].strategy], &tasks[t].stats);
+        cpu_ns[tasks[t].strategy] += tasks[t].cpu_ns;
+    }
+    for(int s=0; s<strategy_count; s++) {
+        lost += total[s].lost;
+        table_errors += total[s].table_errors;
+    }
+    free(tasks);
+    free(listed);
+
+    if(strategy_count == 1) {
+        report(&total[0], wall_ns, jobs);
+        (void) printf("cpu time:   %.3f s (%ld tasks stolen)\n", cpu_ns[0] / 1e9, steals);
+    } else {
+        (void) printf("tournament: %ld games per strategy (%ld workers, %dx%d", games, jobs, variant.slots,
+                      variant.colors);
+        if(secret_set == SAMPLE) {
+            (void) printf(", seed %llu", (unsigned long long)seed);
+        }
+        (void) printf(", %ld tasks stolen)\n", steals);
+        report_tournament(total, cpu_ns, wall_ns);
+    }
+    solver_stats_dump(stdout);
+    if(table_errors != 0) {
+        return EXIT_FAILURE;
+    }
+    return lost == 0 ? EXIT_SUCCESS : 3;
+}
+
+static uint32_t secret_at(long i)
+{
+    switch(secret_set) {
+    case SAMPLE:
+        return (sample_mul * i + sample_add) % variant.codes;
+    case LISTED:
+        return listed[i];
+    default:
+        /* spread the secrets played evenly over all codes */
+        return (uint64_t)i * variant.codes / games;
+    }
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += UINT64_C(0x9e3779b97f4a7c15));
+
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
+static void draw_sample(uint64_t seed)
+{
+    uint64_t a, b;
+
+    sample_add = splitmix64(&seed) % variant.codes;
+    do {
+        sample_mul = splitmix64(&seed) % variant.codes;
+        for(a=sample_mul, b=variant.codes; b != 0; ) {
+            uint64_t r = a % b;
+            a = b;
+            b = r;
+        }
+    } while(a != 1);
+}
+
+static void load_secrets(const char *path)
+{
+    char line[64];
+    long size = 0;
+    FILE *f;
+
+    if((f = fopen(path, "r")) == NULL) {
+        bail_out(EXIT_FAILURE, "Error opening %s", path);
+    }
+    while(fgets(line, sizeof line, f) != NULL) {
+        uint32_t secret = 0, weight = 1;
+        int i;
+
+        if(line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        for(i=0; i<variant.slots; i++, weight*=variant.colors) {
+            const char *digit = line[i] != '\0' ? strchr("0123456789abcdef", line[i]) : NULL;
+            if(digit == NULL || digit - "0123456789abcdef" >= variant.colors) {
+                break;
+            }
+            secret += (digit - "0123456789abcdef") * weight;
+        }
+        if(i != variant.slots || (line[i] != '\n' && line[i] != '\0')) {
+            errno = 0;
+            bail_out(EXIT_FAILURE, "%s: line %ld is not a %dx%d secret", path, games + 1, variant.slots,
+                     variant.colors);
+        }
+        if(games == size) {
+            size = size == 0 ? 1024 : size * 2;
+            uint32_t *grown = realloc(listed, size * sizeof *listed);
+            if(grown == NULL) {
+                bail_out(EXIT_FAILURE, "Error allocating secrets");
+            }
+            listed = grown;
+        }
+        listed[games++] = secret;
+    }
+    (void) fclose(f);
+    if(games == 0) {
+        errno = 0;
+        bail_out(EXIT_FAILURE, "%s lists no secrets", path);
+    }
+    secret_set = LISTED;
+}
+
+static void parse_strategies(char *list)
+{
+    char *name;
+
+    strategy_count = 0;
+    for(name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        if(strategy_count == MAX_STRATEGIES) {
+            bail_out(EXIT_FAILURE, "At most %d strategies", MAX_STRATEGIES);
+        }
+        if(parse_strategy(name, &strategies[strategy_count]) == -1) {
+            bail_out(EXIT_FAILURE, "Argument for -s has to be a list of first, minimax or entropy");
+        }
+        strategy_names[strategy_count++] = name;
+    }
+    if(strategy_count == 0) {
+        bail_out(EXIT_FAILURE, "Argument for -s names no strategy");
+    }
+}
+
+static void play_game(uint32_t secret, int strategy, struct stats *st)
+{
+    uint8_t pins[MAX_SLOTS];
+    int rounds = 0;
+    int red, white;
+    const guess *next;
+    solver *game;
+
+    for(uint32_t i=0, s=secret; i<variant.slots; i++, s/=variant.colors) {
+        pins[i] = s % variant.colors;
+    }
+    if(check_tables) {
+        st->table_errors += check_table(pins);
+    }
+
+    /* the client's opening, pairs of colors: beige beige darkblue darkblue green, unless given with -O */
+    if((game = solver_new_variant(variant.slots, variant.colors, start_guess)) == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating solver");
+    }
+    solver_set_strategy(game, strategies[strategy]);
+    next = solver_guess(game);
+    do {
+        rounds++;
+        if(variant.wide) {
+            uint16_t response;
+            red = compute_wide_answer(&variant, encode_wide_guess(&variant, next->pattern), &response, pins);
+            white = (response >> WIDE_WHITE_SHIFT) & 0xf;
+        } else {
+            uint8_t response;
+            red = compute_answer(encode_guess(next->pattern), &response, pins);
+            white = (response >> SHIFT_WIDTH) & 0x7;
+        }
+        assert(red >= 0);
+        if(red == variant.slots) {
+            break;
+        }
+
+        long long t = now_ns();
+        next = solver_next(game, red, white);
+        t = now_ns() - t;
+
+        st->guess_calls++;
+        st->guess_ns += t;
+        if(t > st->max_guess_ns) {
+            st->max_guess_ns = t;
+        }
+    } while(next != NULL && rounds < MAX_TRIES);
+    solver_free(game);
+
+    st->games++;
+    if(red != variant.slots) {
+        if(st->lost < MAX_LOST_REPORT) {
+            st->lost_secrets[st->lost] = secret;
+        }
+        st->lost++;
+        return;
+    }
+    st->rounds += rounds;
+    st->histogram[rounds]++;
+    if(rounds > st->max_rounds) {
+        st->max_rounds = rounds;
+    }
+}
+
+static long check_table(const uint8_t *pins)
+{
+    uint8_t table[ANSWER_TABLE_SIZE];
+    long errors = 0;
+
+    build_answer_table(pins, table);
+    for(long req=0; req<=UINT16_MAX; req++) {
+        uint8_t expected, got;
+        int ret_expected = compute_answer(req, &expected, pins);
+        int ret_got = table_answer(table, req, &got);
+        if(ret_expected != ret_got || expected != got) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+static long take_task(struct job *self)
+{
+    long t = -1;
+
+    (void) pthread_mutex_lock(&self->lock);
+    if(self->top < self->bottom) {
+        t = --self->bottom;
+    }
+    (void) pthread_mutex_unlock(&self->lock);
+    /* tasks are only dealt out at the start, so once every worker is empty all are taken */
+    for(long i=1; t == -1 && i<jobs; i++) {
+        struct job *victim = &job[(self->id + i) % jobs];
+        (void) pthread_mutex_lock(&victim->lock);
+        if(victim->top < victim->bottom) {
+            t = victim->top++;
+            self->steals++;
+        }
+        (void) pthread_mutex_unlock(&victim->lock);
+    }
+    return t;
+}
+
+static void *worker(void *arg)
+{
+    struct job *self = arg;
+    long t;
+
+    while((t = take_task(self)) != -1) {
+        struct task *task = &tasks[t];
+        struct timespec t0, t1;
+
+        (void) clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+        for(long i=task->first; i<task->last; i++) {
+            play_game(secret_at(i), task->strategy, &task->stats);
+        }
+        (void) clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+        task->cpu_ns = (t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec);
+    }
+    return NULL;
+}
+
+static void merge(struct stats *total, const struct stats *st)
+{
+    for(long i=0; i<st->lost && i<MAX_LOST_REPORT; i++) {
+        if(total->lost + i < MAX_LOST_REPORT) {
+            total->lost_secrets[total->lost + i] = st->lost_secrets[i];
+        }
+    }
+    total->lost += st->lost;
+    total->table_errors += st->table_errors;
+    total->games += st->games;
+    total->rounds += st->rounds;
+    if(st->max_rounds > total->max_rounds) {
+        total->max_rounds = st->max_rounds;
+    }
+    for(int i=0; i<=MAX_TRIES; i++) {
+        total->histogram[i] += st->histogram[i];
+    }
+    total->guess_calls += st->guess_calls;
+    total->guess_ns += st->guess_ns;
+    if(st->max_guess_ns > total->max_guess_ns) {
+        total->max_guess_ns = st->max_guess_ns;
+    }
+}
+
+static void report(const struct stats *st, long long wall_ns, int jobs)
+{
+    long won = st->games - st->lost;
+
+    (void) printf("games:      %ld (%d workers, %dx%d, %s)\n", st->games, jobs, variant.slots, variant.colors,
+                  strategy_names[0]);
+    (void) printf("won:        %ld\n", won);
+    (void) printf("lost:       %ld\n", st->lost);
+    for(long i=0; i<st->lost && i<MAX_LOST_REPORT; i++) {
+        uint32_t s = st->lost_secrets[i];
+        (void) printf("  lost secret:");
+        for(int j=0; j<variant.slots; j++, s/=variant.colors) {
+            (void) printf(" %u", s % variant.colors);
+        }
+        (void) printf("\n");
+    }
+    if(check_tables) {
+        (void) printf("table errors: %ld\n", st->table_errors);
+    }
+    if(won > 0) {
+        (void) printf("rounds:     mean %.4f, max %d\n", (double)st->rounds / won, st->max_rounds);
+    }
+    (void) printf("histogram:\n");
+    for(int i=1; i<=MAX_TRIES; i++) {
+        if(st->histogram[i] != 0) {
+            (void) printf("  %2d: %6ld\n", i, st->histogram[i]);
+        }
+    }
+    if(st->guess_calls > 0) {
+        (void) printf("solver_next: %ld calls, mean %.2f us, max %.2f us\n", st->guess_calls,
+                (double)st->guess_ns / st->guess_calls / 1000.0, (double)st->max_guess_ns / 1000.0);
+    }
+    (void) printf("wall time:  %.3f s (%.1f games/s)\n", wall_ns / 1e9, st->games / (wall_ns / 1e9));
+}
+
+static void report_tournament(const struct stats *st, const long long *cpu_ns, long long wall_ns)
+{
+    int max_rounds = 0;
+
+    for(int s=0; s<strategy_count; s++) {
+        if(st[s].max_rounds > max_rounds) {
+            max_rounds = st[s].max_rounds;
+        }
+    }
+    (void) printf("%-10s %7s %5s %7s", "strategy", "won", "lost", "mean");
+    for(int r=1; r<=max_rounds; r++) {
+        (void) printf(" %6d", r);
+    }
+    (void) printf(" %9s %9s\n", "cpu s", "us/game");
+    for(int s=0; s<strategy_count; s++) {
+        long won = st[s].games - st[s].lost;
+        (void) printf("%-10s %7ld %5ld %7.4f", strategy_names[s], won, st[s].lost,
+                      won > 0 ? (double)st[s].rounds / won : 0.0);
+        for(int r=1; r<=max_rounds; r++) {
+            (void) printf(" %6ld", st[s].histogram[r]);
+        }
+        (void) printf(" %9.3f %9.1f\n", cpu_ns[s] / 1e9, cpu_ns[s] / 1e3 / st[s].games);
+    }
+    (void) printf("wall time:  %.3f s\n", wall_ns / 1e9);
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long parse_long(const char *string)
+{
+    char *endptr;
+    long ret;
+    errno = 0;
+    ret = strtol(string, &endptr, 10);
+    if(errno != 0 || endptr == string || *endptr != '\0') {
+        return -1;
+    }
+    return ret;
+}
+
+static void usage(void)
+{
+    (void) fprintf(stderr, "Usage: %s [-c] [-j <jobs>] [-n <games> | -R <games> [-S <seed>] | -f <secrets>] [-O <openings>]\n"
+                   "       [-s <strategy>[,<strategy>...]] [-v <pins>x<colors>]\n", progname);
+}
+
+static void bail_out(int exitcode, const char *fmt, ...)
+{
+    va_list ap;
+
+    (void) fprintf(stderr, "%s: ", progname);
+    if(fmt != NULL) {
+        va_start(ap, fmt);
+        (void) vfprintf(stderr, fmt, ap);
+        va_end(ap);
+    }
+    if(errno != 0) {
+        (void) fprintf(stderr, ": %s", strerror(errno));
+    }
+    (void) fprintf(stderr, "\n");
+    exit(exitcode);
+}
@@ -4,6 +4,9 @@
 * @date 22.10.2015
 * @brief A client for the Mastermind Server
 * @details Plays a game of Mastermind against the Server. This client will create the guesses automatically
+*          The socket is non-blocking and waited on with poll(), so every request is written and every reply read
+*          completely, within the deadline of the round given with -t. Connecting is retried with -r; once a guess
+*          was sent nothing is retried, as the server counts every request as a round.
 */
 
 
@@ -16,22 +19,46 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include "strategy.h"
+#include "rules.h"
 
 #define BUFFER_BYTES (2)
-#define COLORS (8)
 #define PINS (5)
-#define PARITY_SHIFT (15)
-#define SHIFT_WIDTH (3)
 #define PARITY_ERROR_SHIFT (6)
 #define GAME_LOST_SHIFT (7)
+
+//Game id used on connections speaking the framed protocol
+#define GAME_ID (1)
+
+/*Exit code if the server misses a deadline*/
+#define EXIT_TIMEOUT (5)
+
+/*Wait before the first connect retry, doubled up to MAX_BACKOFF_MS on every further one*/
+#define BACKOFF_MS (100)
+#define MAX_BACKOFF_MS (1600)
+
+#define USAGE "Usage: client [-m] [-O <openings>] [-r <retries>] [-s <strategy>] [-t <ms>] [-v <pins>x<colors>]\n" \
+              "              {<server-hostname> <server-port> | -u <socket-path>}"
+
 //Struct containing the options passed to the program
 struct opts {
     long int portno;
     char *addr;
+    char *unix_path;    //NULL if the server is reached over TCP
+    int framed;
+    struct variant variant;
+    enum solver_strategy strategy;
+    char *openings;     //table of the opening tool, NULL to play the built-in opening
+    long timeout;       //milliseconds to connect and to play one round, -1 to wait forever
+    long retries;       //further connect attempts
 };
 
 //Enum for managing the colors
@@ -40,6 +67,16 @@ enum color {beige = 0, darkblue, green, orange, red, black, violet, white};
 //name of the program
 static const char *progname = "client";
 
+//whether the server is spoken to with the framed protocol
+static int framed = 0;
+
+//number of pins and colors; variants other than 5x8 use the wide encoding
+static struct variant variant;
+
+//milliseconds a round may take, -1 for no limit, and the end of the current round
+static long timeout = -1;
+static long long deadline = -1;
+
 /**
  * Credit to the OSUE-Team
  * @brief Parse command line options
@@ -67,69 +104,143 @@ static void free_resources(void);
  * @brief Sends the next guess to the mastermind server
  * @param guess An integer array containing the next guess
  */
-void send_guess(int *guess);
+void send_guess(const int *guess);
 
 /**
  * @brief Receives the answer from the server
+ * @detail With the framed protocol the whole reply frame is read and its game id checked, with the wide encoding
+ *         both reply bytes are read
  * @param fd File descriptor of the socket
  * @param buff Buffer which will hold the received data
  * @return The pointer to the buffer if data was received, NULL else
  * */
 static uint8_t *receive_answer(int fd, uint8_t *buff);
+
+/**
+ * @brief Current value of the monotonic clock
+ * @return Milliseconds since an arbitrary point in time
+ */
+static long long now_ms(void);
+
+/**
+ * @brief Waits until a socket is ready
+ * @param fd The socket
+ * @param events POLLIN or POLLOUT
+ * @param until Deadline from now_ms(), -1 to wait forever
+ * @return 0 if the socket is ready, -1 on error or with errno ETIMEDOUT if the deadline passed
+ */
+static int wait_ready(int fd, short events, long long until);
+
+/**
+ * @brief Writes a whole buffer to a non-blocking socket
+ * @param fd The socket
+ * @param buf The data
+ * @param len Number of bytes
+ * @param until Deadline from now_ms(), -1 to wait forever
+ * @return 0 on success, -1 on error or with errno ETIMEDOUT if the deadline passed
+ */
+static int write_all(int fd, const void *buf, size_t len, long long until);
+
+/**
+ * @brief Reads a whole buffer from a non-blocking socket
+ * @param fd The socket
+ * @param buf Receives the data
+ * @param len Number of bytes
+ * @param until Deadline from now_ms(), -1 to wait forever
+ * @return 0 on success, -1 on error, end of file (errno ECONNRESET) or with errno ETIMEDOUT if the deadline passed
+ */
+static int read_all(int fd, void *buf, size_t len, long long until);
+
+/**
+ * @brief Connects a new non-blocking socket once
+ * @param addr Address of the server
+ * @param len Length of the address
+ * @param until Deadline from now_ms(), -1 to wait forever
+ * @return The socket, or -1 on error
+ */
+static int try_connect(const struct sockaddr *addr, socklen_t len, long long until);
+
+/**
+ * @brief Connects to the server
+ * @detail TCP connections disable Nagle's algorithm: every round is a small write followed by a read, which would
+ *         otherwise wait for the delayed acknowledgement of the previous round. A failed attempt is retried up to
+ *         arg->retries times with exponential backoff, each attempt limited to arg->timeout.
+ * @param arg The parsed options
+ */
+static void connect_server(const struct opts *arg);
+
 static int sockfd = -1;
 
+//the state of the game
+static solver *game = NULL;
+
 
 /**
  *@brief Main entry point of the program, Game logic
  *@detail This method implements the connection to the server, as well as the main game logic (Playing out the strategy, sending and receiving data)
  * @param argc Number of arguments passed to the program
  * @param argv Array containing the passed arguments
- * @return EXIT_SUCCESS when game is won, EXIT_FAILURE on error, 2 on parity error, 3 if game is lost, 4 if game is lost and parity error occured
+ * @return EXIT_SUCCESS when game is won, EXIT_FAILURE on error, 2 on parity error, 3 if game is lost, 4 if game is lost and parity error occured, 5 if the server missed a deadline
  * */
  
 int main(int argc, char *argv[]) 
 {
-    int initial_guess[PINS] = {beige, beige, darkblue, darkblue, green}; 
+    int initial_guess[MAX_PINS] = {beige, beige, darkblue, darkblue, green};
     struct opts arg;
     parse_args(argc, argv, &arg);
-    struct sockaddr_in sin;
-    static uint8_t response[1];
-    memset(&sin, 0, sizeof sin);
-    sin.sin_family = AF_INET;
-    sin.sin_port = htons(arg.portno);
+    if(solver_stats_signal() == -1) {
+        bail_out(EXIT_FAILURE, "Error installing signal handler");
+    }
+    framed = arg.framed;
+    variant = arg.variant;
+    timeout = arg.timeout;
+    static uint8_t response[WIDE_REPLY_BYTES];
     int red = 0;
     int white = 0;
     int parity_err = 0;
     int lost = 0;
     int rounds_played = 0;
-    guess *next = NULL;
-    if(inet_pton(AF_INET, arg.addr, &sin.sin_addr) <= 0) {
-        bail_out(EXIT_FAILURE, "Invalid server IP");
+    const guess *next = NULL;
+
+    connect_server(&arg);
+    if(arg.openings != NULL) {
+        if(load_opening(arg.openings, variant.slots, variant.colors, initial_guess) == -1) {
+            bail_out(EXIT_FAILURE, "Error loading an opening for %dx%d from %s", variant.slots, variant.colors,
+                     arg.openings);
+        }
     }
-    
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if(sockfd == -1) {
-        bail_out(EXIT_FAILURE, "Error creating socket");
+    game = solver_new_variant(variant.slots, variant.colors,
+                              variant.wide && arg.openings == NULL ? NULL : initial_guess);
+    if(game == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating solver");
     }
-
-    if(connect(sockfd, (struct sockaddr *)&sin, sizeof sin) == -1) {
-         bail_out(EXIT_FAILURE, "Error connecting socket");
-    } 
-    next = init_strat(initial_guess);
+    solver_set_strategy(game, arg.strategy);
+    next = solver_guess(game);
 
     do {
+        deadline = timeout < 0 ? -1 : now_ms() + timeout;
         send_guess(next->pattern);
         if(receive_answer(sockfd, response)==NULL) {
-             bail_out(EXIT_FAILURE, "Error reading server reply");
+             bail_out(errno == ETIMEDOUT ? EXIT_TIMEOUT : EXIT_FAILURE, "Error reading server reply");
+        }
+        if(variant.wide) {
+            uint16_t reply = response[0] | (response[1] << 8);
+            lost = reply&(0x1<<WIDE_GAME_LOST_ERR_BIT);
+            parity_err = reply&(0x1<<WIDE_PARITY_ERR_BIT);
+            red = reply&0xf;
+            white = (reply>>WIDE_WHITE_SHIFT)&0xf;
+        } else {
+            lost = response[0]&(0x1<<GAME_LOST_SHIFT);
+            parity_err = response[0]&(0x1<<PARITY_ERROR_SHIFT);
+            red = response[0]&0x7;
+            white = (response[0]>>SHIFT_WIDTH)&0x7;
         }
-        lost = response[0]&(0x1<<GAME_LOST_SHIFT);
-        parity_err = response[0]&(0x1<<PARITY_ERROR_SHIFT);
-        red = response[0]&0x7;
-        white = (response[0]>>SHIFT_WIDTH)&0x7;
-        next = next_guess(red, white);
         rounds_played++;
+        if(lost == 0 && parity_err == 0 && red != variant.slots && (next = solver_next(game, red, white)) == NULL) {
+            bail_out(EXIT_FAILURE, "No guess left, server replies are inconsistent");
+        }
     }
-    while(lost == 0 && parity_err == 0 && red != PINS);
+    while(lost == 0 && parity_err == 0 && red != variant.slots);
     if(lost != 0) {
         if(parity_err != 0) {
             (void)printf("Game lost");
@@ -140,41 +251,198 @@ int main(int argc, char *argv[])
     else if(parity_err != 0) {
         bail_out(2, "Parity error");
     }
-    if(red == PINS) {
+    if(red == variant.slots) {
         (void)printf("%d", rounds_played);
-        free_all();
+        free_resources();
         return EXIT_SUCCESS;
     }          
 }
 
+static void connect_server(const struct opts *arg)
+{
+    struct sockaddr_in sin;
+    struct sockaddr_un sun;
+    struct sockaddr *addr;
+    socklen_t len;
+    long backoff = BACKOFF_MS;
+    int optval = 1;
+
+    if(arg->unix_path != NULL) {
+        memset(&sun, 0, sizeof sun);
+        sun.sun_family = AF_UNIX;
+        if(strlen(arg->unix_path) >= sizeof sun.sun_path) {
+            bail_out(EXIT_FAILURE, "Socket path too long");
+        }
+        strcpy(sun.sun_path, arg->unix_path);
+        addr = (struct sockaddr *)&sun;
+        len = sizeof sun;
+    } else {
+        memset(&sin, 0, sizeof sin);
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons(arg->portno);
+        if(inet_pton(AF_INET, arg->addr, &sin.sin_addr) <= 0) {
+            bail_out(EXIT_FAILURE, "Invalid server IP");
+        }
+        addr = (struct sockaddr *)&sin;
+        len = sizeof sin;
+    }
+
+    for(long attempt=0; (sockfd = try_connect(addr, len, timeout < 0 ? -1 : now_ms() + timeout)) == -1; attempt++) {
+        struct timespec pause = {backoff / 1000, (backoff % 1000) * 1000000L};
+        if(attempt == arg->retries) {
+            bail_out(errno == ETIMEDOUT ? EXIT_TIMEOUT : EXIT_FAILURE, "Error connecting socket");
+        }
+        (void) nanosleep(&pause, NULL);
+        backoff = backoff * 2 < MAX_BACKOFF_MS ? backoff * 2 : MAX_BACKOFF_MS;
+    }
+    if(arg->unix_path == NULL && setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof optval) == -1) {
+        bail_out(EXIT_FAILURE, "Error setting TCP_NODELAY");
+    }
+}
+
+static int try_connect(const struct sockaddr *addr, socklen_t len, long long until)
+{
+    int fd, err;
+    socklen_t errlen = sizeof err;
+
+    if((fd = socket(addr->sa_family, SOCK_STREAM, 0)) == -1) {
+        return -1;
+    }
+    if(fcntl(fd, F_SETFL, O_NONBLOCK) == -1) {
+        err = errno;
+        (void) close(fd);
+        errno = err;
+        return -1;
+    }
+    if(connect(fd, addr, len) == 0) {
+        return fd;
+    }
+    /* a UNIX socket with a full backlog fails with EAGAIN instead of waiting */
+    if(errno != EINPROGRESS
+       || wait_ready(fd, POLLOUT, until) == -1
+       || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errlen) == -1
+       || (err != 0 && (errno = err) != 0)) {
+        err = errno;
+        (void) close(fd);
+        errno = err;
+        return -1;
+    }
+    errno = 0;
+    return fd;
+}
+
+static long long now_ms(void)
+{
+    struct timespec ts;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static int wait_ready(int fd, short events, long long until)
+{
+    struct pollfd pfd = {fd, events, 0};
+    int ret;
+
+    do {
+        long long left = until < 0 ? -1 : until - now_ms();
+        if(until >= 0 && left <= 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        ret = poll(&pfd, 1, left > INT_MAX ? INT_MAX : (int)left);
+    } while(ret == 0 || (ret == -1 && errno == EINTR));
+    return ret == -1 ? -1 : 0;
+}
+
+static int write_all(int fd, const void *buf, size_t len, long long until)
+{
+    const uint8_t *p = buf;
+
+    while(len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if(n == -1) {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return -1;
+            }
+            if(wait_ready(fd, POLLOUT, until) == -1) {
+                return -1;
+            }
+            continue;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void *buf, size_t len, long long until)
+{
+    uint8_t *p = buf;
+
+    while(len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if(n == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if(n == -1) {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return -1;
+            }
+            if(wait_ready(fd, POLLIN, until) == -1) {
+                return -1;
+            }
+            continue;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
 static uint8_t *receive_answer(int fd, uint8_t *buff) 
 {
-    ssize_t rb;
-    rb = recv(fd, buff, 1, 0);
-    if(rb <= 0) {
+    if(framed) {
+        uint8_t frame[MUX_REPLY_BYTES];
+        if(read_all(fd, frame, sizeof frame, deadline) == -1) {
+            return NULL;
+        }
+        if(mux_frame_id(frame) != GAME_ID) {
+            errno = EPROTO;
+            return NULL;
+        }
+        buff[0] = frame[MUX_REPLY_BYTES - 1];
+        return buff;
+    }
+    if(read_all(fd, buff, variant.wide ? WIDE_REPLY_BYTES : 1, deadline) == -1) {
         return NULL;
     }
     return buff;
 }
 
-void send_guess(int *guess)
+void send_guess(const int *guess)
 {
-    uint16_t enc_guess = 0;
-    uint8_t parity = 0; 
-    int tmp;
-    for(int i=1; i<=PINS; i++) {
-        enc_guess <<= SHIFT_WIDTH;
-        enc_guess += guess[PINS-i];
-        tmp = enc_guess & 0x7;
-        parity ^= tmp ^ (tmp >> 1) ^ (tmp >> 2);
-    }
-    parity &= 0x1;
-    enc_guess += parity << PARITY_SHIFT;   
+    uint16_t enc_guess = encode_guess(guess);
+    uint8_t frame[MUX_REQUEST_BYTES];
 
-    errno = 0;
-    send(sockfd, &enc_guess, sizeof(enc_guess), 0);
-    if(errno != 0) {
-        bail_out(EXIT_FAILURE, "Error sending guess to server!");
+    int ret;
+
+    if(variant.wide) {
+        uint32_t wide_guess = encode_wide_guess(&variant, guess);
+        uint8_t request[WIDE_REQUEST_BYTES];
+        for(int i=0; i<WIDE_REQUEST_BYTES; i++) {
+            request[i] = (wide_guess >> (8 * i)) & 0xff;
+        }
+        ret = write_all(sockfd, request, sizeof request, deadline);
+    } else if(framed) {
+        mux_pack_request(frame, GAME_ID, enc_guess);
+        ret = write_all(sockfd, frame, sizeof frame, deadline);
+    } else {
+        ret = write_all(sockfd, &enc_guess, sizeof(enc_guess), deadline);
+    }
+    if(ret == -1) {
+        bail_out(errno == ETIMEDOUT ? EXIT_TIMEOUT : EXIT_FAILURE, "Error sending guess to server!");
     }
 }
        
@@ -185,6 +453,8 @@ static void free_resources(void)
     if(sockfd >= 0) {
         (void) close(sockfd);
     }
+    solver_free(game);
+    solver_stats_dump(stderr);
 }
 
 static void bail_out(int exitcode, const char *fmt, ...) 
@@ -193,7 +463,7 @@ static void bail_out(int exitcode, const char *fmt, ...)
     (void) fprintf(stderr, "%s: ", progname);
     if(fmt != NULL) {
         va_start(ap, fmt);
-        (void) fprintf(stderr, fmt, ap);
+        (void) vfprintf(stderr, fmt, ap);
         va_end(ap);
     }
     if(errno != 0) {
@@ -202,18 +472,76 @@ static void bail_out(int exitcode, const char *fmt, ...)
     (void) fprintf(stderr, "\n");
    
     free_resources();
-    free_all();
     exit(exitcode);
 
 } 
 void parse_args(int argc, char *argv[], struct opts* arg) 
 {
     char *endptr;
-    if(argc != 3) {
-        bail_out(EXIT_FAILURE, "Usage: client <server-hostname> <server-port>");
-    }
-    
+    int c;
+
     progname = argv[0];
+    arg->framed = 0;
+    arg->unix_path = NULL;
+    (void) variant_init(&arg->variant, SLOTS, COLORS);
+    arg->strategy = STRATEGY_FIRST;
+    arg->openings = NULL;
+    arg->timeout = -1;
+    arg->retries = 0;
+    while((c = getopt(argc, argv, "mO:r:s:t:u:v:")) != -1) {
+        switch(c) {
+        case 'm':
+            arg->framed = 1;
+            break;
+        case 'O':
+            arg->openings = optarg;
+            break;
+        case 'r':
+            errno = 0;
+            arg->retries = strtol(optarg, &endptr, 10);
+            if(errno != 0 || endptr == optarg || *endptr != '\0' || arg->retries < 0) {
+                bail_out(EXIT_FAILURE, "Argument for -r not a number of retries");
+            }
+            break;
+        case 's':
+            if(parse_strategy(optarg, &arg->strategy) == -1) {
+                bail_out(EXIT_FAILURE, "Unknown strategy, use first, minimax or entropy");
+            }
+            break;
+        case 't':
+            errno = 0;
+            arg->timeout = strtol(optarg, &endptr, 10);
+            if(errno != 0 || endptr == optarg || *endptr != '\0' || arg->timeout <= 0) {
+                bail_out(EXIT_FAILURE, "Argument for -t not a positive number of milliseconds");
+            }
+            break;
+        case 'u':
+            arg->unix_path = optarg;
+            break;
+        case 'v':
+            if(parse_variant(optarg, &arg->variant) == -1) {
+                bail_out(EXIT_FAILURE, "Unsupported variant, at most %d pins and %d colors", MAX_SLOTS, MAX_COLORS);
+            }
+            break;
+        default:
+            bail_out(EXIT_FAILURE, USAGE);
+        }
+    }
+    //the framed protocol only carries the classic encoding
+    if(arg->framed && arg->variant.wide) {
+        bail_out(EXIT_FAILURE, USAGE);
+    }
+    if(arg->unix_path != NULL) {
+        //the UNIX socket of the server only speaks the classic protocol
+        if(argc != optind || arg->framed) {
+            bail_out(EXIT_FAILURE, USAGE);
+        }
+        return;
+    }
+    if(argc - optind != 2) {
+        bail_out(EXIT_FAILURE, USAGE);
+    }
+    argv += optind - 1; //positional arguments start at argv[1]
 
     errno = 0;
     arg->portno = strtol(argv[2], &endptr, 10);
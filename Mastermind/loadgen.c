@@ -0,0 +1,708 @@
+/** Mastermind Load Generator
+* @file: loadgen.c
+* @author Michael Reitgruber
+* @date 18.10.2026
+* @brief Plays many concurrent games against a Mastermind server and measures its capacity
+* @details A few threads each drive a share of the connections from their own epoll loop. Every connection plays
+*          one game after the other with the client strategy and records the latency of every round (request sent
+*          to reply received) in a log-linear histogram. At the end games/s, rounds/s and latency percentiles are
+*          reported.
+*          The strategy is deterministic, so all games walk the same decision tree: the next guess only depends on
+*          the replies received so far. The tree is shared by all threads and grown on demand; a missing node is
+*          computed by replaying its path with a solver and published with a compare-and-swap, after that it is a
+*          lock-free pointer lookup. Growing the tree stalls the thread doing it, so -p builds the whole tree before
+*          the connections are opened.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "strategy.h"
+#include "rules.h"
+
+/*Number of different replies without error bits: red and white pins*/
+#define REPLIES (1 << (2 * SHIFT_WIDTH))
+
+/*Histogram: values below HIST_SUB are exact, above that every power of two is split into HIST_SUB/2 buckets*/
+#define HIST_SUB_BITS (5)
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (HIST_SUB + 64 * (HIST_SUB / 2))
+
+/*Number of events handled per call to epoll_wait*/
+#define MAX_EVENTS (256)
+
+enum color {beige = 0, darkblue, green, orange, red, black, violet, white};
+
+//A node of the strategy's decision tree
+struct node {
+    struct node *parent;
+    struct node *child[REPLIES];    //indexed by the reply that leads there
+    uint8_t reply;                  //reply leading from the parent to this node
+    uint16_t request;               //the guess to play, encoded
+};
+
+//Log-linear latency histogram in nanoseconds
+struct hist {
+    unsigned long count[HIST_BUCKETS];
+    unsigned long total;
+    long long max;
+};
+
+enum state {CONNECTING, PLAYING};
+
+//One connection, playing one game at a time
+struct conn {
+    int fd;
+    enum state state;
+    struct node *node;      //position in the decision tree
+    int rounds;
+    long long sent_ns;      //time the last request was sent
+};
+
+//One load generating thread
+struct thread {
+    pthread_t tid;
+    int id;
+    int epfd;
+    int nconns;
+    struct conn *conns;
+    struct hist hist;
+    unsigned long games;
+    unsigned long rounds;
+    unsigned long lost;
+    unsigned long errors;
+};
+
+//Options passed to the program
+struct opts {
+    long threads;
+    long connections;
+    long duration;
+    long warmup;
+    int prebuild;
+    int unix_socket;        //whether sun is used instead of sin
+    struct sockaddr_in sin;
+    struct sockaddr_un sun;
+};
+
+//name of the program
+static const char *progname = "loadgen";
+
+//the decision tree
+static struct node *root;
+
+//the opening guess of the client
+static int initial_guess[SLOTS] = {beige, beige, darkblue, darkblue, green};
+
+//the options
+static struct opts options;
+
+//time when measuring starts and stops
+static long long measure_start_ns;
+static long long measure_end_ns;
+
+/**
+ * Credit to the OSUE-Team
+ * @brief terminate program on program error
+ * @param exitcode exit code
+ * @param fmt format string
+ */
+static void bail_out(int exitcode, const char *fmt, ...);
+
+/**
+ * @brief Prints correct usage of program to stderr
+ */
+static void usage(void);
+
+/**
+ * @brief Parses a positive integer
+ * @param string The string to be parsed
+ * @return The parsed integer, or -1 on failure
+ */
+static long parse_long(const char *string);
+
+/**
+ * @brief Parses the TCP address of the server into the options
+ * @param host The IPv4 address or localhost
+ * @param port The port
+ */
+static void parse_address(const char *host, const char *port);
+
+/**
+ * @brief Current value of the monotonic clock
+ * @return Nanoseconds since an arbitrary point in time
+ */
+static long long now_ns(void);
+
+/**
+ * @brief Returns the child of a node, computing it if necessary
+ * @param n The node
+ * @param reply The reply received for the guess of the node
+ * @return The child, or NULL if the strategy has no guess left
+ */
+static struct node *child(struct node *n, uint8_t reply);
+
+/**
+ * @brief Creates a node of the decision tree
+ * @param parent The parent node, or NULL for the root
+ * @param reply The reply leading from the parent to the node
+ * @param pattern The guess to play at the node
+ * @return The node
+ */
+static struct node *new_node(struct node *parent, uint8_t reply, const int *pattern);
+
+/**
+ * @brief Frees a subtree of the decision tree
+ * @param n The root of the subtree
+ */
+static void free_tree(struct node *n);
+
+/**
+ * @brief Grows the decision tree to cover every secret, so the measurement is not disturbed by tree growth
+ */
+static void prebuild_tree(void);
+
+/**
+ * @brief Adds a value to a histogram
+ * @param h The histogram
+ * @param v The value
+ */
+static void hist_add(struct hist *h, long long v);
+
+/**
+ * @brief Returns the value at a percentile of a histogram
+ * @param h The histogram
+ * @param percentile The percentile (0-100)
+ * @return The highest value equivalent to the bucket containing the percentile, at most the largest value seen
+ */
+static long long hist_percentile(const struct hist *h, double percentile);
+
+/**
+ * @brief Starts a new game on a connection
+ * @param t The thread owning the connection
+ * @param c The connection
+ */
+static void start_game(struct thread *t, struct conn *c);
+
+/**
+ * @brief Sends the guess of the current node of a connection
+ * @param t The thread owning the connection
+ * @param c The connection
+ * @return 0 on success, -1 on error
+ */
+static int send_request(struct thread *t, struct conn *c);
+
+/**
+ * @brief Handles an event on a connection
+ * @param t The thread owning the connection
+ * @param c The connection
+ * @param events The epoll events
+ */
+static void handle_event(struct thread *t, struct conn *c, uint32_t events);
+
+/**
+ * @brief Closes a connection
+ * @param c The connection
+ */
+static void close_conn(struct conn *c);
+
+/**
+ * @brief The procedure representing one load generating thread
+ * @param arg The thread
+ * @return NULL
+ */
+static void *run_thread(void *arg);
+
+/**
+ * @brief Main entry point, starts the threads and prints the report
+ * @param argc Number of arguments passed to the program
+ * @param argv Array containing the passed arguments
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+int main(int argc, char *argv[])
+{
+    struct rlimit rl;
+    struct thread *threads;
+    struct hist total;
+    unsigned long games = 0, rounds = 0, lost = 0, errors = 0;
+    int c;
+
+    if(argc > 0) {
+        progname = argv[0];
+    }
+    options.threads = 1;
+    options.connections = 100;
+    options.duration = 10;
+    options.warmup = 1;
+    while((c = getopt(argc, argv, "t:c:d:w:pu:")) != -1) {
+        switch(c) {
+        case 't':
+            if((options.threads = parse_long(optarg)) <= 0) {
+                bail_out(EXIT_FAILURE, "Argument for -t not a positive integer");
+            }
+            break;
+        case 'c':
+            if((options.connections = parse_long(optarg)) <= 0) {
+                bail_out(EXIT_FAILURE, "Argument for -c not a positive integer");
+            }
+            break;
+        case 'd':
+            if((options.duration = parse_long(optarg)) <= 0) {
+                bail_out(EXIT_FAILURE, "Argument for -d not a positive integer");
+            }
+            break;
+        case 'w':
+            if((options.warmup = parse_long(optarg)) < 0) {
+                bail_out(EXIT_FAILURE, "Argument for -w not an integer");
+            }
+            break;
+        case 'p':
+            options.prebuild = 1;
+            break;
+        case 'u':
+            options.unix_socket = 1;
+            options.sun.sun_family = AF_UNIX;
+            if(strlen(optarg) >= sizeof options.sun.sun_path) {
+                bail_out(EXIT_FAILURE, "Socket path too long");
+            }
+            strcpy(options.sun.sun_path, optarg);
+            break;
+        case '?':
+            usage();
+            return EXIT_FAILURE;
+        default: assert(0);
+        }
+    }
+    if(argc - optind != (options.unix_socket ? 0 : 2)) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    if(options.threads > options.connections) {
+        options.threads = options.connections;
+    }
+    if(!options.unix_socket) {
+        parse_address(argv[optind], argv[optind + 1]);
+    }
+
+    /* tens of thousands of connections need as many descriptors */
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        (void) setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    root = new_node(NULL, 0, initial_guess);
+    if(options.prebuild) {
+        prebuild_tree();
+    }
+
+    threads = calloc(options.threads, sizeof *threads);
+    if(threads == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating threads");
+    }
+    measure_start_ns = now_ns() + options.warmup * 1000000000LL;
+    measure_end_ns = measure_start_ns + options.duration * 1000000000LL;
+    for(int i=0; i<options.threads; i++) {
+        struct thread *t = &threads[i];
+        t->id = i;
+        t->nconns = options.connections / options.threads
+                    + (i < options.connections % options.threads);
+        if((t->conns = calloc(t->nconns, sizeof *t->conns)) == NULL) {
+            bail_out(EXIT_FAILURE, "Error allocating connections");
+        }
+        if((t->epfd = epoll_create(MAX_EVENTS)) == -1) {
+            bail_out(EXIT_FAILURE, "Error creating epoll instance");
+        }
+        if((errno = pthread_create(&t->tid, NULL, run_thread, t)) != 0) {
+            bail_out(EXIT_FAILURE, "Error starting thread");
+        }
+    }
+
+    (void) memset(&total, 0, sizeof total);
+    for(int i=0; i<options.threads; i++) {
+        struct thread *t = &threads[i];
+        (void) pthread_join(t->tid, NULL);
+        for(int j=0; j<HIST_BUCKETS; j++) {
+            total.count[j] += t->hist.count[j];
+        }
+        total.total += t->hist.total;
+        if(t->hist.max > total.max) {
+            total.max = t->hist.max;
+        }
+        games += t->games;
+        rounds += t->rounds;
+        lost += t->lost;
+        errors += t->errors;
+        (void) close(t->epfd);
+        free(t->conns);
+    }
+    free(threads);
+    free_tree(root);
+
+    (void) printf("connections: %ld (%ld threads), duration: %ld s\n",
+                  options.connections, options.threads, options.duration);
+    (void) printf("games:       %lu (%.1f games/s), lost: %lu, errors: %lu\n",
+                  games, (double)games / options.duration, lost, errors);
+    (void) printf("rounds:      %lu (%.1f rounds/s)\n", rounds, (double)rounds / options.duration);
+    if(total.total > 0) {
+        const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+        (void) printf("round latency (us):\n");
+        for(int i=0; i<sizeof percentiles / sizeof percentiles[0]; i++) {
+            (void) printf("  p%-6g %10.1f\n", percentiles[i], hist_percentile(&total, percentiles[i]) / 1000.0);
+        }
+        (void) printf("  max     %10.1f\n", total.max / 1000.0);
+    }
+    return EXIT_SUCCESS;
+}
+
+static struct node *new_node(struct node *parent, uint8_t reply, const int *pattern)
+{
+    struct node *n = calloc(1, sizeof *n);
+    if(n == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating tree node");
+    }
+    n->parent = parent;
+    n->reply = reply;
+    n->request = encode_guess(pattern);
+    return n;
+}
+
+static struct node *child(struct node *n, uint8_t reply)
+{
+    struct node *ch = __atomic_load_n(&n->child[reply], __ATOMIC_ACQUIRE);
+    struct node *expected = NULL;
+    uint8_t path[MAX_TRIES];
+    int len = 0;
+    const guess *g;
+    solver *game;
+
+    if(ch != NULL) {
+        return ch;
+    }
+
+    /* replay the replies from the root to n, then the new one */
+    path[len++] = reply;
+    for(struct node *p = n; p->parent != NULL && len < MAX_TRIES; p = p->parent) {
+        path[len++] = p->reply;
+    }
+    if((game = solver_new(initial_guess)) == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating solver");
+    }
+    g = solver_guess(game);
+    while(len > 0 && g != NULL) {
+        len--;
+        g = solver_next(game, path[len] & 0x7, path[len] >> SHIFT_WIDTH);
+    }
+    if(g != NULL) {
+        ch = new_node(n, reply, g->pattern);
+        /* another thread may have computed the same node meanwhile */
+        if(!__atomic_compare_exchange_n(&n->child[reply], &expected, ch, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free(ch);
+            ch = expected;
+        }
+    }
+    solver_free(game);
+    return ch;
+}
+
+static void prebuild_tree(void)
+{
+    uint8_t secret[SLOTS];
+    uint8_t reply;
+
+    for(int s=0; s<ANSWER_TABLE_SIZE; s++) {
+        for(int j=0; j<SLOTS; j++) {
+            secret[j] = (s >> (SHIFT_WIDTH * j)) & 0x7;
+        }
+        for(struct node *n = root; n != NULL; n = child(n, reply & (REPLIES - 1))) {
+            (void) compute_answer(n->request, &reply, secret);
+            if((reply & 0x7) == SLOTS) {
+                break;
+            }
+        }
+    }
+}
+
+static void free_tree(struct node *n)
+{
+    for(int i=0; i<REPLIES; i++) {
+        if(n->child[i] != NULL) {
+            free_tree(n->child[i]);
+        }
+    }
+    free(n);
+}
+
+static void hist_add(struct hist *h, long long v)
+{
+    int idx;
+    if(v < 0) {
+        v = 0;
+    }
+    if(v < HIST_SUB) {
+        idx = v;
+    } else {
+        int shift = (63 - __builtin_clzll(v)) - (HIST_SUB_BITS - 1);
+        idx = HIST_SUB + (shift - 1) * (HIST_SUB / 2) + (int)((v >> shift) - HIST_SUB / 2);
+    }
+    h->count[idx]++;
+    h->total++;
+    if(v > h->max) {
+        h->max = v;
+    }
+}
+
+static long long hist_percentile(const struct hist *h, double percentile)
+{
+    unsigned long rank = (unsigned long)(percentile / 100.0 * h->total + 0.5);
+    unsigned long seen = 0;
+
+    if(rank == 0) {
+        rank = 1;
+    }
+    for(int idx=0; idx<HIST_BUCKETS; idx++) {
+        seen += h->count[idx];
+        if(seen >= rank) {
+            int shift, sub;
+            long long high;
+            if(idx < HIST_SUB) {
+                return idx;
+            }
+            shift = (idx - HIST_SUB) / (HIST_SUB / 2) + 1;
+            sub = (idx - HIST_SUB) % (HIST_SUB / 2) + HIST_SUB / 2;
+            high = (((long long)sub + 1) << shift) - 1;
+            /* the bucket of the maximum reaches past it; never report a percentile above max */
+            return high < h->max ? high : h->max;
+        }
+    }
+    return h->max;
+}
+
+static void start_game(struct thread *t, struct conn *c)
+{
+    struct epoll_event ev;
+    int flags, err;
+
+    c->fd = socket(options.unix_socket ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
+    if(c->fd == -1) {
+        bail_out(EXIT_FAILURE, "Error creating socket");
+    }
+    if(!options.unix_socket) {
+        int optval = 1;
+        if(setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof optval) == -1) {
+            bail_out(EXIT_FAILURE, "Error setting TCP_NODELAY");
+        }
+    }
+    flags = fcntl(c->fd, F_GETFL, 0);
+    if(flags == -1 || fcntl(c->fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        bail_out(EXIT_FAILURE, "Error setting socket non-blocking");
+    }
+    c->state = CONNECTING;
+    c->node = root;
+    c->rounds = 0;
+    if(options.unix_socket) {
+        err = connect(c->fd, (struct sockaddr *)&options.sun, sizeof options.sun);
+    } else {
+        err = connect(c->fd, (struct sockaddr *)&options.sin, sizeof options.sin);
+    }
+    /* a full UNIX socket backlog fails with EAGAIN instead of waiting */
+    if(err == -1 && errno != EINPROGRESS && errno != EAGAIN) {
+        bail_out(EXIT_FAILURE, "Error connecting socket");
+    }
+    ev.events = EPOLLOUT;
+    ev.data.ptr = c;
+    if(epoll_ctl(t->epfd, EPOLL_CTL_ADD, c->fd, &ev) == -1) {
+        bail_out(EXIT_FAILURE, "Error watching socket");
+    }
+}
+
+static int send_request(struct thread *t, struct conn *c)
+{
+    uint16_t request = c->node->request;
+    uint8_t buf[2] = {request & 0xff, request >> 8};
+
+    c->sent_ns = now_ns();
+    /* a fresh request always fits into the socket buffer: the server has
+       answered everything sent before */
+    if(send(c->fd, buf, sizeof buf, MSG_NOSIGNAL) != sizeof buf) {
+        return -1;
+    }
+    return 0;
+}
+
+static void handle_event(struct thread *t, struct conn *c, uint32_t events)
+{
+    struct epoll_event ev;
+    uint8_t reply;
+    long long now;
+
+    if(c->state == CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof err;
+        if(getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1 || err != 0) {
+            t->errors++;
+            close_conn(c);
+            start_game(t, c);
+            return;
+        }
+        c->state = PLAYING;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if(epoll_ctl(t->epfd, EPOLL_CTL_MOD, c->fd, &ev) == -1 || send_request(t, c) == -1) {
+            t->errors++;
+            close_conn(c);
+            start_game(t, c);
+        }
+        return;
+    }
+
+    ssize_t r = recv(c->fd, &reply, 1, 0);
+    if(r == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if(r != 1) {
+        t->errors++;
+        close_conn(c);
+        start_game(t, c);
+        return;
+    }
+    now = now_ns();
+    c->rounds++;
+    if(now >= measure_start_ns && now < measure_end_ns) {
+        hist_add(&t->hist, now - c->sent_ns);
+        t->rounds++;
+    }
+
+    if((reply & 0x7) == SLOTS || (reply & ((1 << PARITY_ERR_BIT) | (1 << GAME_LOST_ERR_BIT)))) {
+        if(now >= measure_start_ns && now < measure_end_ns) {
+            t->games++;
+            if((reply & 0x7) != SLOTS) {
+                t->lost++;
+            }
+        }
+        close_conn(c);
+        if(now < measure_end_ns) {
+            start_game(t, c);
+        }
+        return;
+    }
+
+    c->node = child(c->node, reply & (REPLIES - 1));
+    if(c->node == NULL || send_request(t, c) == -1) {
+        t->errors++;
+        close_conn(c);
+        start_game(t, c);
+    }
+}
+
+static void close_conn(struct conn *c)
+{
+    if(c->fd >= 0) {
+        (void) close(c->fd);
+        c->fd = -1;
+    }
+}
+
+static void *run_thread(void *arg)
+{
+    struct thread *t = arg;
+    struct epoll_event events[MAX_EVENTS];
+    int open = t->nconns;
+
+    for(int i=0; i<t->nconns; i++) {
+        start_game(t, &t->conns[i]);
+    }
+    while(open > 0) {
+        long long now = now_ns();
+        if(now >= measure_end_ns) {
+            break;
+        }
+        int n = epoll_wait(t->epfd, events, MAX_EVENTS, (int)((measure_end_ns - now) / 1000000) + 1);
+        if(n == -1) {
+            if(errno == EINTR) continue;
+            bail_out(EXIT_FAILURE, "epoll_wait");
+        }
+        for(int i=0; i<n; i++) {
+            handle_event(t, events[i].data.ptr, events[i].events);
+        }
+    }
+    for(int i=0; i<t->nconns; i++) {
+        close_conn(&t->conns[i]);
+    }
+    return NULL;
+}
+
+static void parse_address(const char *host, const char *port)
+{
+    long portno = parse_long(port);
+
+    if(portno < 1 || portno > 65535) {
+        bail_out(EXIT_FAILURE, "Port is not a valid TCP/IP port");
+    }
+    options.sin.sin_family = AF_INET;
+    options.sin.sin_port = htons(portno);
+    if(strcmp(host, "localhost") == 0) {
+        host = "127.0.0.1";
+    }
+    if(inet_pton(AF_INET, host, &options.sin.sin_addr) <= 0) {
+        bail_out(EXIT_FAILURE, "Invalid server IP");
+    }
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long parse_long(const char *string)
+{
+    char *endptr;
+    long ret;
+    errno = 0;
+    ret = strtol(string, &endptr, 10);
+    if(errno != 0 || endptr == string || *endptr != '\0') {
+        return -1;
+    }
+    return ret;
+}
+
+static void usage(void)
+{
+    (void) fprintf(stderr, "Usage: %s [-p] [-t <threads>] [-c <connections>] [-d <seconds>] [-w <warmup-seconds>] "
+                   "{<server-hostname> <server-port> | -u <socket-path>}\n", progname);
+}
+
+static void bail_out(int exitcode, const char *fmt, ...)
+{
+    va_list ap;
+
+    (void) fprintf(stderr, "%s: ", progname);
+    if(fmt != NULL) {
+        va_start(ap, fmt);
+        (void) vfprintf(stderr, fmt, ap);
+        va_end(ap);
+    }
+    if(errno != 0) {
+        (void) fprintf(stderr, ": %s", strerror(errno));
+    }
+    (void) fprintf(stderr, "\n");
+    exit(exitcode);
+}
@@ -0,0 +1,345 @@
+/** Mastermind Opening Search
+* @file: opening.c
+* @author Michael Reitgruber
+* @date 18.10.2026
+* @brief Rates every opening guess of a Mastermind variant and writes a ranked table
+* @details Relabeling the colors of a guess does not change how well it splits the codes, so only the canonical
+*          openings are rated: the first pin has color 0 and every other pin repeats a color used before or takes the
+*          next unused one. Each opening is scored against all codes, which are partitioned by their reply; an
+*          opening is rated by the largest partition, the number of candidates expected to be left and the entropy
+*          of the reply. The openings are spread among one worker thread per core.
+*          The table starts with the variant, followed by one opening per line, best first; client and bench play
+*          the first one when given the table with -O.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "rules.h"
+
+/*Number of different replies, red * (MAX_SLOTS + 1) + white*/
+#define MAX_REPLIES ((MAX_SLOTS + 1) * (MAX_SLOTS + 1))
+
+//How the openings are ranked
+enum rank_by {BY_WORST = 0, BY_EXPECTED, BY_ENTROPY};
+
+//One opening and its rating
+struct opening {
+    uint8_t pattern[MAX_SLOTS];
+    uint32_t worst;         //size of the largest partition
+    double expected;        //candidates expected to be left
+    double entropy;         //bits of information of the reply
+};
+
+//One worker thread
+struct job {
+    pthread_t thread;
+};
+
+//name of the program
+static const char *progname = "opening";
+
+//the number of pins and colors
+static struct variant variant;
+
+//the canonical openings, rated by the workers
+static struct opening *openings = NULL;
+static long opening_count = 0;
+
+//next opening to be rated
+static long next_opening = 0;
+
+//the criterion the table is ranked by
+static enum rank_by rank_by = BY_EXPECTED;
+
+/**
+ * Credit to the OSUE-Team
+ * @brief terminate program on program error
+ * @param exitcode exit code
+ * @param fmt format string
+ */
+static void bail_out(int exitcode, const char *fmt, ...);
+
+/**
+ * @brief Prints correct usage of program to stderr
+ */
+static void usage(void);
+
+/**
+ * @brief Parses a positive integer
+ * @param string The string to be parsed
+ * @return The parsed integer, or -1 on failure
+ */
+static long parse_long(const char *string);
+
+/**
+ * @brief Lists the canonical openings
+ * @detail The openings are listed in ascending order, pin by pin
+ * @param pattern The pins chosen so far, filled up recursively
+ * @param pin The next pin to choose
+ * @param used Number of colors used by the pins chosen so far
+ */
+static void list_openings(uint8_t *pattern, int pin, int used);
+
+/**
+ * @brief Scores an opening against every code and rates the partitions
+ * @param o The opening
+ */
+static void rate(struct opening *o);
+
+/**
+ * @brief The procedure representing one worker thread
+ * @detail Rates openings until none is left
+ * @param arg The job of the worker
+ * @return NULL
+ */
+static void *worker(void *arg);
+
+/**
+ * @brief Orders two openings by the rank criterion, then by the other criteria, then by pattern
+ * @param a The first opening
+ * @param b The second opening
+ * @return Negative if a ranks before b, positive if after
+ */
+static int compare(const void *a, const void *b);
+
+/**
+ * @brief Writes the ranked table
+ * @param out The stream
+ */
+static void write_table(FILE *out);
+
+/**
+ * @brief Main entry point, spawns the workers and writes the table
+ * @param argc Number of arguments passed to the program
+ * @param argv Array containing the passed arguments
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+int main(int argc, char *argv[])
+{
+    static const char *criteria[] = {"worst", "expected", "entropy"};
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *path = NULL;
+    uint8_t pattern[MAX_SLOTS];
+    FILE *out = stdout;
+    int c;
+
+    if(argc > 0) {
+        progname = argv[0];
+    }
+    (void) variant_init(&variant, SLOTS, COLORS);
+    while((c = getopt(argc, argv, "j:o:r:v:")) != -1) {
+        switch(c) {
+        case 'j':
+            if((jobs = parse_long(optarg)) <= 0) {
+                bail_out(EXIT_FAILURE, "Argument for -j not a positive integer");
+            }
+            break;
+        case 'o':
+            path = optarg;
+            break;
+        case 'r':
+            for(rank_by=BY_WORST; rank_by<=BY_ENTROPY && strcmp(optarg, criteria[rank_by]) != 0; rank_by++);
+            if(rank_by > BY_ENTROPY) {
+                bail_out(EXIT_FAILURE, "Argument for -r has to be worst, expected or entropy");
+            }
+            break;
+        case 'v':
+            if(parse_variant(optarg, &variant) == -1) {
+                bail_out(EXIT_FAILURE, "Argument for -v has to be <pins>x<colors>, at most %dx%d",
+                         MAX_SLOTS, MAX_COLORS);
+            }
+            break;
+        case '?':
+            usage();
+            return EXIT_FAILURE;
+        default: assert(0);
+        }
+    }
+    if(optind != argc) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    /* count the openings first, then list them */
+    list_openings(pattern, 0, 0);
+    if((openings = calloc(opening_count, sizeof *openings)) == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating openings");
+    }
+    opening_count = 0;
+    list_openings(pattern, 0, 0);
+
+    if(jobs > opening_count) {
+        jobs = opening_count;
+    }
+    struct job *job = calloc(jobs, sizeof *job);
+    if(job == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating workers");
+    }
+    for(int i=0; i<jobs; i++) {
+        if((errno = pthread_create(&job[i].thread, NULL, worker, &job[i])) != 0) {
+            bail_out(EXIT_FAILURE, "Error starting worker");
+        }
+    }
+    for(int i=0; i<jobs; i++) {
+        (void) pthread_join(job[i].thread, NULL);
+    }
+    free(job);
+
+    qsort(openings, opening_count, sizeof *openings, compare);
+    if(path != NULL && (out = fopen(path, "w")) == NULL) {
+        bail_out(EXIT_FAILURE, "Error opening %s", path);
+    }
+    (void) fprintf(out, "# %ld openings of %dx%d up to color symmetry, ranked by %s\n", opening_count,
+                   variant.slots, variant.colors, criteria[rank_by]);
+    write_table(out);
+    if(out != stdout && fclose(out) != 0) {
+        bail_out(EXIT_FAILURE, "Error writing %s", path);
+    }
+    free(openings);
+    return EXIT_SUCCESS;
+}
+
+static void list_openings(uint8_t *pattern, int pin, int used)
+{
+    if(pin == variant.slots) {
+        if(openings != NULL) {
+            (void) memcpy(openings[opening_count].pattern, pattern, variant.slots);
+        }
+        opening_count++;
+        return;
+    }
+    for(int c=0; c<=used && c<variant.colors; c++) {
+        pattern[pin] = c;
+        list_openings(pattern, pin + 1, c == used ? used + 1 : used);
+    }
+}
+
+static void rate(struct opening *o)
+{
+    uint32_t sizes[MAX_REPLIES] = {0};
+    uint8_t guess_colors[MAX_COLORS] = {0};
+    uint8_t code[MAX_SLOTS] = {0};
+    double n = variant.codes;
+
+    for(int i=0; i<variant.slots; i++) {
+        guess_colors[o->pattern[i]]++;
+    }
+    for(uint32_t k=0; k<variant.codes; k++) {
+        uint8_t colors[MAX_COLORS] = {0};
+        int red = 0, common = 0, i;
+
+        for(i=0; i<variant.slots; i++) {
+            red += (code[i] == o->pattern[i]);
+            /* the n-th pin of a color is in common if the guess has at least n pins of it */
+            common += (colors[code[i]]++ < guess_colors[code[i]]);
+        }
+        sizes[red * (variant.slots + 1) + common - red]++;
+
+        /* next code, the first pin fastest */
+        for(i=0; i<variant.slots && ++code[i] == variant.colors; i++) {
+            code[i] = 0;
+        }
+    }
+
+    o->worst = 0;
+    o->expected = 0;
+    o->entropy = 0;
+    for(int r=0; r<MAX_REPLIES; r++) {
+        if(sizes[r] == 0) {
+            continue;
+        }
+        if(sizes[r] > o->worst) {
+            o->worst = sizes[r];
+        }
+        /* a code is left with the others of its partition */
+        o->expected += (double)sizes[r] * sizes[r] / n;
+        o->entropy -= sizes[r] / n * log2(sizes[r] / n);
+    }
+}
+
+static void *worker(void *arg)
+{
+    long i;
+
+    (void) arg;
+    while((i = __atomic_fetch_add(&next_opening, 1, __ATOMIC_RELAXED)) < opening_count) {
+        rate(&openings[i]);
+    }
+    return NULL;
+}
+
+static int compare(const void *a, const void *b)
+{
+    const struct opening *x = a, *y = b;
+    double keys_x[] = {x->worst, x->expected, -x->entropy};
+    double keys_y[] = {y->worst, y->expected, -y->entropy};
+
+    if(keys_x[rank_by] != keys_y[rank_by]) {
+        return keys_x[rank_by] < keys_y[rank_by] ? -1 : 1;
+    }
+    for(int k=0; k<3; k++) {
+        if(keys_x[k] != keys_y[k]) {
+            return keys_x[k] < keys_y[k] ? -1 : 1;
+        }
+    }
+    return memcmp(x->pattern, y->pattern, variant.slots);
+}
+
+static void write_table(FILE *out)
+{
+    (void) fprintf(out, "%dx%d\n", variant.slots, variant.colors);
+    (void) fprintf(out, "# opening     worst     expected  entropy\n");
+    for(long i=0; i<opening_count; i++) {
+        char pattern[MAX_SLOTS + 1];
+        for(int j=0; j<variant.slots; j++) {
+            pattern[j] = "0123456789abcdef"[openings[i].pattern[j]];
+        }
+        pattern[variant.slots] = '\0';
+        (void) fprintf(out, "%-9s %9u %12.3f %8.4f\n", pattern, openings[i].worst, openings[i].expected,
+                       openings[i].entropy);
+    }
+}
+
+static long parse_long(const char *string)
+{
+    char *endptr;
+    long ret;
+
+    errno = 0;
+    ret = strtol(string, &endptr, 10);
+    if(errno != 0 || endptr == string || *endptr != '\0') {
+        return -1;
+    }
+    return ret;
+}
+
+static void usage(void)
+{
+    (void) fprintf(stderr, "Usage: %s [-j <jobs>] [-o <table>] [-r worst|expected|entropy] [-v <pins>x<colors>]\n",
+                   progname);
+}
+
+static void bail_out(int exitcode, const char *fmt, ...)
+{
+    va_list ap;
+
+    (void) fprintf(stderr, "%s: ", progname);
+    if(fmt != NULL) {
+        va_start(ap, fmt);
+        (void) vfprintf(stderr, fmt, ap);
+        va_end(ap);
+    }
+    if(errno != 0) {
+        (void) fprintf(stderr, ": %s", strerror(errno));
+    }
+    (void) fprintf(stderr, "\n");
+    exit(exitcode);
+}
@@ -0,0 +1,222 @@
+/** Mastermind Rules
+* @file: rules.c
+* @author Michael Reitgruber
+* @date 18.10.2026
+* @brief Wire encoding and scoring shared by the server and the offline tools
+* @details compute_answer() is the server's scoring routine (Credit to OSUE-Team), moved here so the
+*          benchmark can score games in-process exactly like the server does
+*/
+
+#include "rules.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define P2(n) n, n ^ 1, n ^ 1, n
+#define P4(n) P2(n), P2(n ^ 1), P2(n ^ 1), P2(n)
+#define P6(n) P4(n), P4(n ^ 1), P4(n ^ 1), P4(n)
+
+const uint8_t parity_table[256] = { P6(0), P6(1), P6(1), P6(0) };
+
+uint16_t encode_guess(const int *pattern)
+{
+    uint16_t enc_guess = 0;
+    uint8_t parity = 0;
+    int tmp;
+    for(int i=1; i<=SLOTS; i++) {
+        enc_guess <<= SHIFT_WIDTH;
+        enc_guess += pattern[SLOTS-i];
+        tmp = enc_guess & 0x7;
+        parity ^= tmp ^ (tmp >> 1) ^ (tmp >> 2);
+    }
+    parity &= 0x1;
+    enc_guess += parity << PARITY_SHIFT;
+    return enc_guess;
+}
+
+int compute_answer(uint16_t req, uint8_t *resp, const uint8_t *secret)
+{
+    int colors_left[COLORS];
+    int guess[COLORS];
+    uint8_t parity_calc, parity_recv;
+    int red, white;
+    int j;
+
+    parity_recv = (req >> PARITY_SHIFT) & 1;
+
+    /* extract the guess and calculate parity */
+    parity_calc = 0;
+    for (j = 0; j < SLOTS; ++j) {
+        int tmp = req & 0x7;
+        parity_calc ^= tmp ^ (tmp >> 1) ^ (tmp >> 2);
+        guess[j] = tmp;
+        req >>= SHIFT_WIDTH;
+    }
+    parity_calc &= 0x1;
+
+    /* marking red and white */
+    (void) memset(&colors_left[0], 0, sizeof(colors_left));
+    red = white = 0;
+    for (j = 0; j < SLOTS; ++j) {
+        /* mark red */
+        if (guess[j] == secret[j]) {
+            red++;
+        } else {
+            colors_left[secret[j]]++;
+        }
+    }
+    for (j = 0; j < SLOTS; ++j) {
+        /* not marked red */
+        if (guess[j] != secret[j]) {
+            if (colors_left[guess[j]] > 0) {
+                white++;
+                colors_left[guess[j]]--;
+            }
+        }
+    }
+
+    /* build response buffer */
+    resp[0] = red;
+    resp[0] |= (white << SHIFT_WIDTH);
+    if (parity_recv != parity_calc) {
+        resp[0] |= (1 << PARITY_ERR_BIT);
+        return -1;
+    } else {
+        return red;
+    }
+}
+
+int variant_init(struct variant *v, int slots, int colors)
+{
+    uint64_t codes = 1;
+
+    if (slots < 1 || slots > MAX_SLOTS || colors < 2 || colors > MAX_COLORS) {
+        return -1;
+    }
+    for (int j = 0; j < slots; ++j) {
+        codes *= colors;
+    }
+    if (codes > (1u << WIDE_PARITY_SHIFT)) {
+        return -1;
+    }
+    v->slots = slots;
+    v->colors = colors;
+    v->codes = codes;
+    v->wide = (slots != SLOTS || colors != COLORS);
+    return 0;
+}
+
+int parse_variant(const char *arg, struct variant *v)
+{
+    char *endptr;
+    long slots, colors;
+
+    errno = 0;
+    slots = strtol(arg, &endptr, 10);
+    if (errno != 0 || endptr == arg || *endptr != 'x') {
+        return -1;
+    }
+    arg = endptr + 1;
+    colors = strtol(arg, &endptr, 10);
+    if (errno != 0 || endptr == arg || *endptr != '\0'
+        || slots > MAX_SLOTS || colors > MAX_COLORS) {
+        return -1;
+    }
+    return variant_init(v, slots, colors);
+}
+
+uint32_t encode_wide_guess(const struct variant *v, const int *pattern)
+{
+    uint32_t index = 0;
+
+    for (int j = v->slots - 1; j >= 0; --j) {
+        index = index * v->colors + pattern[j];
+    }
+    return index | ((uint32_t)(__builtin_popcount(index) & 1) << WIDE_PARITY_SHIFT);
+}
+
+int compute_wide_answer(const struct variant *v, uint32_t req, uint16_t *resp, const uint8_t *secret)
+{
+    int colors_left[MAX_COLORS];
+    uint32_t index = req & ~(1u << WIDE_PARITY_SHIFT);
+    int red, white;
+    uint32_t guess;
+    int j;
+
+    if (index >= v->codes
+        || (uint32_t)(__builtin_popcount(index) & 1) != req >> WIDE_PARITY_SHIFT) {
+        *resp = 1 << WIDE_PARITY_ERR_BIT;
+        return -1;
+    }
+
+    /* marking red and white, as compute_answer() */
+    (void) memset(&colors_left[0], 0, sizeof(colors_left));
+    red = white = 0;
+    for (j = 0, guess = index; j < v->slots; ++j, guess /= v->colors) {
+        if (guess % v->colors == secret[j]) {
+            red++;
+        } else {
+            colors_left[secret[j]]++;
+        }
+    }
+    for (j = 0, guess = index; j < v->slots; ++j, guess /= v->colors) {
+        int color = guess % v->colors;
+        if (color != secret[j] && colors_left[color] > 0) {
+            white++;
+            colors_left[color]--;
+        }
+    }
+    *resp = red | (white << WIDE_WHITE_SHIFT);
+    return red;
+}
+
+void build_answer_table(const uint8_t *secret, uint8_t *table)
+{
+    int secret_colors[COLORS] = {0};
+    int guess_colors[COLORS];
+    int pins[SLOTS];
+
+    for (int j = 0; j < SLOTS; ++j) {
+        secret_colors[secret[j]]++;
+    }
+    for (int req = 0; req < ANSWER_TABLE_SIZE; ++req) {
+        int red = 0, common = 0;
+
+        (void) memset(guess_colors, 0, sizeof guess_colors);
+        for (int j = 0; j < SLOTS; ++j) {
+            pins[j] = (req >> (j * SHIFT_WIDTH)) & 0x7;
+            red += (pins[j] == secret[j]);
+            guess_colors[pins[j]]++;
+        }
+        /* every color in common is either a red or a white pin */
+        for (int c = 0; c < COLORS; ++c) {
+            common += guess_colors[c] < secret_colors[c] ? guess_colors[c] : secret_colors[c];
+        }
+        table[req] = red | ((common - red) << SHIFT_WIDTH);
+    }
+}
+
+void mux_pack_request(uint8_t *buf, uint32_t id, uint16_t req)
+{
+    buf[0] = id & 0xff;
+    buf[1] = (id >> 8) & 0xff;
+    buf[2] = (id >> 16) & 0xff;
+    buf[3] = (id >> 24) & 0xff;
+    buf[4] = req & 0xff;
+    buf[5] = (req >> 8) & 0xff;
+}
+
+void mux_pack_reply(uint8_t *buf, uint32_t id, uint8_t resp)
+{
+    buf[0] = id & 0xff;
+    buf[1] = (id >> 8) & 0xff;
+    buf[2] = (id >> 16) & 0xff;
+    buf[3] = (id >> 24) & 0xff;
+    buf[4] = resp;
+}
+
+uint32_t mux_frame_id(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8)
+           | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
@@ -0,0 +1,161 @@
+/** Mastermind Rules
+* @file: rules.h
+* @author Michael Reitgruber
+* @date 18.10.2026
+* @brief Wire encoding and scoring shared by the server and the offline tools
+*/
+
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdint.h>
+
+#define MAX_TRIES (35)
+#define SLOTS (5)
+#define COLORS (8)
+
+#define SHIFT_WIDTH (3)
+#define PARITY_SHIFT (15)
+#define PARITY_ERR_BIT (6)
+#define GAME_LOST_ERR_BIT (7)
+
+/* Framed protocol: many games over one connection. A request frame is the
+   game id (4 bytes) followed by the classic 2 byte request, a reply frame is
+   the game id followed by the classic reply byte, all little endian. A game
+   starts with the first frame carrying its id and ends with the reply that
+   reports a win, a loss or a parity error; the id may be reused afterwards. */
+#define MUX_REQUEST_BYTES (6)
+#define MUX_REPLY_BYTES (5)
+
+/* Other numbers of pins and colors use the wide encoding: the request is
+   the index of the guess (the colors as digits in base colors, first pin
+   least significant) in bits 0-30 with the parity of those bits in bit 31,
+   the reply holds the red pins in bits 0-3, the white pins in bits 4-7 and
+   the error flags in bits 8 and 9; both are little endian. */
+#define MAX_SLOTS (8)
+#define MAX_COLORS (16)
+#define WIDE_REQUEST_BYTES (4)
+#define WIDE_REPLY_BYTES (2)
+#define WIDE_PARITY_SHIFT (31)
+#define WIDE_WHITE_SHIFT (4)
+#define WIDE_PARITY_ERR_BIT (8)
+#define WIDE_GAME_LOST_ERR_BIT (9)
+
+/* Number of pins and colors of a game */
+struct variant {
+    int slots;
+    int colors;
+    uint32_t codes;     /* colors^slots */
+    int wide;           /* whether the wide encoding is used */
+};
+
+/* Number of distinct guesses (requests without the parity bit) */
+#define ANSWER_TABLE_SIZE (1 << (SLOTS * SHIFT_WIDTH))
+
+/* Parity of every byte */
+extern const uint8_t parity_table[256];
+
+/**
+ * @brief Encodes a guess the way the client sends it (3 bits per pin, parity in bit 15)
+ * @param pattern The colors of the pins
+ * @return The 16 bit request
+ */
+uint16_t encode_guess(const int *pattern);
+
+/**
+ * @brief Compute answer to request
+ * @param req Client's guess
+ * @param resp Buffer that will be sent to the client
+ * @param secret The server's secret
+ * @return Number of correct matches on success; -1 in case of a parity error
+ */
+int compute_answer(uint16_t req, uint8_t *resp, const uint8_t *secret);
+
+/**
+ * @brief Sets up a variant
+ * @param v The variant
+ * @param slots Number of pins (1-MAX_SLOTS)
+ * @param colors Number of colors (2-MAX_COLORS)
+ * @return 0 on success, -1 if the variant is not supported
+ */
+int variant_init(struct variant *v, int slots, int colors);
+
+/**
+ * @brief Parses a variant given as <pins>x<colors>, e.g. 6x10
+ * @param arg The argument
+ * @param v Receives the variant
+ * @return 0 on success, -1 if the argument is malformed or the variant not supported
+ */
+int parse_variant(const char *arg, struct variant *v);
+
+/**
+ * @brief Encodes a guess in the wide encoding
+ * @param v The variant
+ * @param pattern The colors of the pins
+ * @return The 32 bit request
+ */
+uint32_t encode_wide_guess(const struct variant *v, const int *pattern);
+
+/**
+ * @brief Compute answer to a request in the wide encoding
+ * @detail A request for a guess that does not exist counts as a parity error
+ * @param v The variant
+ * @param req Client's guess
+ * @param resp Receives the reply
+ * @param secret The server's secret
+ * @return Number of correct matches on success; -1 in case of a parity error
+ */
+int compute_wide_answer(const struct variant *v, uint32_t req, uint16_t *resp, const uint8_t *secret);
+
+/**
+ * @brief Precomputes the reply to every guess for one secret
+ * @detail The entries hold red and white pins without the parity bit, see table_answer()
+ * @param secret The secret
+ * @param table Buffer of ANSWER_TABLE_SIZE bytes
+ */
+void build_answer_table(const uint8_t *secret, uint8_t *table);
+
+/**
+ * @brief Compute answer to request with a table built by build_answer_table()
+ * @detail Gives the same results as compute_answer() for the secret of the table
+ * @param table The answer table of the secret
+ * @param req Client's guess
+ * @param resp Buffer that will be sent to the client
+ * @return Number of correct matches on success; -1 in case of a parity error
+ */
+static inline int table_answer(const uint8_t *table, uint16_t req, uint8_t *resp)
+{
+    uint8_t parity = parity_table[req & 0xff] ^ parity_table[(req >> 8) & 0x7f];
+
+    resp[0] = table[req & (ANSWER_TABLE_SIZE - 1)];
+    if (parity != ((req >> PARITY_SHIFT) & 1)) {
+        resp[0] |= (1 << PARITY_ERR_BIT);
+        return -1;
+    }
+    return resp[0] & 0x7;
+}
+
+/**
+ * @brief Builds a request frame of the framed protocol
+ * @param buf Buffer of MUX_REQUEST_BYTES bytes
+ * @param id The game id
+ * @param req The classic request
+ */
+void mux_pack_request(uint8_t *buf, uint32_t id, uint16_t req);
+
+/**
+ * @brief Builds a reply frame of the framed protocol
+ * @param buf Buffer of MUX_REPLY_BYTES bytes
+ * @param id The game id
+ * @param resp The classic reply
+ */
+void mux_pack_reply(uint8_t *buf, uint32_t id, uint8_t resp);
+
+/**
+ * @brief Reads the game id of a request or reply frame
+ * @param buf The frame
+ * @return The game id
+ */
+uint32_t mux_frame_id(const uint8_t *buf);
+
+#endif
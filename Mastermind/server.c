@@ -23,36 +23,50 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <fcntl.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <signal.h>
 #include <errno.h>
 #include <limits.h>
+#include <pthread.h>
+#include "rules.h"
+#include "trace.h"
 
 
 /* === Constants === */
 
-#define MAX_TRIES (35)
-#define SLOTS (5)
-#define COLORS (8)
+#define BACKLOG (SOMAXCONN)
 
-#define READ_BYTES (2)
-#define WRITE_BYTES (1)
-#define BUFFER_BYTES (2)
-#define SHIFT_WIDTH (3)
-#define PARITY_ERR_BIT (6)
-#define GAME_LOST_ERR_BIT (7)
+/* Number of events handled per call to epoll_wait */
+#define MAX_EVENTS (256)
 
-#define EXIT_PARITY_ERROR (2)
-#define EXIT_GAME_LOST (3)
-#define EXIT_MULTIPLE_ERRORS (4)
+/* Size of the input and output buffer of a framed connection; every request
+   frame produces a shorter reply frame, so a full input buffer always fits
+   into an empty output buffer */
+#define MUX_BUFFER_BYTES (4096)
 
-#define BACKLOG (5)
+/* Maximum number of concurrent games on one framed connection */
+#define MUX_MAX_GAMES (1 << 16)
+
+/* Number of answer tables cached per worker */
+#define TABLE_CACHE_SIZE (8)
+
+/* Number of recently started random secrets remembered per worker; a
+   random secret only gets a table when it is seen again */
+#define RECENT_SECRETS (64)
+
+/* Table index of a game without an answer table */
+#define NO_TABLE (0xff)
 
 
 /* === Macros === */
-#define ENDEBUG
 #ifdef ENDEBUG
 #define DEBUG(...) do { fprintf(stderr, __VA_ARGS__); } while(0)
 #else
@@ -62,29 +76,119 @@
 /* Length of an array */
 #define COUNT_OF(x) (sizeof(x)/sizeof(x[0]))
 
+
+/* === Type Definitions === */
+
+struct opts {
+    long int portno;
+    long int muxportno;         /* 0 if the framed protocol is disabled */
+    const char *unix_path;      /* NULL if the UNIX socket is disabled */
+    const char *trace_path;     /* NULL if tracing is disabled */
+    long int workers;
+    struct variant variant;
+    size_t request_bytes;       /* size of a request and a reply on the wire */
+    size_t reply_bytes;
+    int random_secret;
+    uint8_t secret[MAX_SLOTS];
+};
+
+/* One game of a framed connection */
+struct mux_game {
+    uint32_t id;
+    uint8_t used;
+    uint8_t round;
+    uint8_t table;              /* index into the answer table cache */
+    uint8_t secret[SLOTS];
+};
+
+/* State of a framed connection carrying many games */
+struct mux {
+    struct mux_game *games;     /* hash table, open addressing */
+    uint32_t mask;              /* number of slots - 1 */
+    uint32_t count;             /* number of running games */
+    uint16_t in_len;            /* bytes of partial frames in `in` */
+    uint16_t out_off;           /* bytes of `out` already sent */
+    uint16_t out_len;
+    uint8_t in[MUX_BUFFER_BYTES];
+    uint8_t out[MUX_BUFFER_BYTES];
+};
+
+/* State of one connection; a classic connection plays one game */
+struct conn {
+    struct conn *prev;
+    struct conn *next;
+    struct mux *mux;                /* NULL for a classic connection */
+    int fd;
+    uint32_t serial;                /* connection number within the worker */
+    uint8_t round;
+    uint8_t table;                  /* index into the answer table cache */
+    uint8_t secret[MAX_SLOTS];
+    uint8_t request[WIDE_REQUEST_BYTES];    /* partially received request */
+    uint8_t received;               /* bytes of request received so far */
+    uint8_t reply[WIDE_REPLY_BYTES];    /* reply waiting for the socket to drain */
+    uint8_t reply_sent;             /* bytes of it already sent */
+    uint8_t reply_pending;
+    uint8_t done;                   /* close after the pending reply is sent */
+};
+
+/* Game statistics, printed at shutdown */
+struct stats {
+    unsigned long games;
+    unsigned long won;
+    unsigned long lost;
+    unsigned long parity_errors;
+    unsigned long aborted;
+    unsigned long rounds;
+};
+
+/* Precomputed replies for one secret, shared by all games with that secret */
+struct answer_table {
+    uint8_t *answers;           /* ANSWER_TABLE_SIZE entries */
+    uint16_t key;               /* the secret, 3 bits per pin */
+    unsigned long refs;         /* number of running games using the table */
+    unsigned long last_use;
+};
+
+/* One event loop; workers share nothing but the options and the wakeup pipe */
+struct worker {
+    pthread_t thread;
+    int id;
+    int sockfd;                 /* own SO_REUSEPORT listener */
+    int muxfd;                  /* own listener for the framed protocol */
+    int epfd;
+    struct conn *conns;         /* list of open connections */
+    struct stats stats;
+    uint64_t rng_state;         /* generator for random secrets */
+    struct answer_table tables[TABLE_CACHE_SIZE];
+    unsigned long table_clock;
+    uint16_t recent[RECENT_SECRETS];
+    unsigned int recent_pos;
+    uint32_t conn_serial;       /* number of connections accepted */
+    struct trace_ring trace;
+    const struct opts *options;
+};
+
+
 /* === Global Variables === */
 
 /* Name of the program */
 static const char *progname = "server"; /* default name */
 
-/* File descriptor for server socket */
-static int sockfd = -1;
+/* The event loops */
+static struct worker **workers = NULL;
+static int num_workers = 0;
 
-/* File descriptor for connection socket */
-static int connfd = -1;
+/* Pipe written by the signal handler to wake up every event loop */
+static int wakeup[2] = {-1, -1};
+
+/* UNIX-domain listener shared by all workers, and its path */
+static int unixfd = -1;
+static const char *unix_path = NULL;
 
 /* This variable is set upon receipt of a signal */
 volatile sig_atomic_t quit = 0;
 
 
-/* === Type Definitions === */
-
-struct opts {
-    long int portno;
-    uint8_t secret[SLOTS];
-};
-
-
 /* === Prototypes === */
 
 /**
@@ -96,25 +200,164 @@ struct opts {
 static void parse_args(int argc, char **argv, struct opts *options);
 
 /**
- * @brief Read message from socket
- *
- * This code *illustrates* one way to deal with partial reads
- *
- * @param sockfd_con Socket to read from
- * @param buffer Buffer where read data is stored
- * @param n Size to read
- * @return Pointer to buffer on success, else NULL
+ * @brief Parse a TCP port number
+ * @param port_arg The argument
+ * @param name Name of the argument for error messages
+ * @return The port
+ */
+static long int parse_port(const char *port_arg, const char *name);
+
+/**
+ * @brief Create a non-blocking SO_REUSEPORT listening socket
+ * @param sin The address to listen on
+ * @return The socket
+ */
+static int create_listener(const struct sockaddr_in *sin);
+
+/**
+ * @brief Create the non-blocking UNIX-domain listening socket
+ * @detail A stale socket left behind at the path is replaced
+ * @param path The path to bind to
+ */
+static void create_unix_listener(const char *path);
+
+/**
+ * @brief Create the listening sockets and epoll instance of a worker
+ * @param w The worker
+ * @param sin The address of the classic protocol
+ * @param muxsin The address of the framed protocol, or NULL
+ */
+static void setup_worker(struct worker *w, const struct sockaddr_in *sin,
+                         const struct sockaddr_in *muxsin);
+
+/**
+ * @brief The event loop of one worker thread
+ * @param arg The worker
+ * @return NULL
  */
-static uint8_t *read_from_client(int sockfd_con, uint8_t *buffer, size_t n);
+static void *run_worker(void *arg);
 
 /**
- * @brief Compute answer to request
- * @param req Client's guess
- * @param resp Buffer that will be sent to the client
- * @param secret The server's secret
- * @return Number of correct matches on success; -1 in case of a parity error
+ * @brief Accept all pending connections
+ * @param w The worker owning the listening socket
+ * @param listenfd The listening socket
+ * @param framed Whether the connections speak the framed protocol
  */
-static int compute_answer(uint16_t req, uint8_t *resp, uint8_t *secret);
+static void accept_games(struct worker *w, int listenfd, int framed);
+
+/**
+ * @brief Read whatever the client sent and answer complete requests
+ * @param w The worker owning the connection
+ * @param c The connection that became readable
+ */
+static void handle_input(struct worker *w, struct conn *c);
+
+/**
+ * @brief Send replies that could not be sent right away
+ * @param w The worker owning the connection
+ * @param c The connection that became writable
+ */
+static void handle_output(struct worker *w, struct conn *c);
+
+/**
+ * @brief Play one round of a game
+ * @param w The worker owning the game
+ * @param c The connection carrying the game
+ * @param game Id of the game on a framed connection, 0 on a classic one
+ * @param round Round counter of the game, incremented
+ * @param secret The secret of the game
+ * @param table The answer table of the game, or NO_TABLE
+ * @param request The client's guess
+ * @param reply Receives the reply
+ * @return 1 if the game is over, 0 else
+ */
+static int play_round(struct worker *w, const struct conn *c, uint32_t game,
+                      uint8_t *round, const uint8_t *secret, uint8_t table,
+                      uint32_t request, uint16_t *reply);
+
+/**
+ * @brief Find or build the answer table of a secret
+ * @detail Tables are only built for secrets that repeat: the configured
+ * secret, or a random secret that was drawn again recently. If every cached
+ * table is in use the game is scored with compute_answer().
+ * @param w The worker owning the cache
+ * @param secret The secret of a new game
+ * @return Index of the table, or NO_TABLE
+ */
+static uint8_t table_get(struct worker *w, const uint8_t *secret);
+
+/**
+ * @brief Release the answer table of a finished game
+ * @param w The worker owning the cache
+ * @param table Index of the table, or NO_TABLE
+ */
+static void table_put(struct worker *w, uint8_t table);
+
+/**
+ * @brief Send one reply, or queue what is left of it if the socket is full
+ * @param w The worker owning the connection
+ * @param c The connection
+ * @param reply The reply to send, one or two bytes on the wire
+ * @return 0 on success, -1 if the connection failed
+ */
+static int send_reply(struct worker *w, struct conn *c, uint16_t reply);
+
+/**
+ * @brief Read and answer the frames of a framed connection
+ * @param w The worker owning the connection
+ * @param c The connection
+ */
+static void mux_input(struct worker *w, struct conn *c);
+
+/**
+ * @brief Send the buffered reply frames of a framed connection
+ * @param w The worker owning the connection
+ * @param c The connection
+ * @return 0 if everything was sent, 1 if the socket is full, -1 on error
+ */
+static int mux_flush(struct worker *w, struct conn *c);
+
+/**
+ * @brief Look up a game of a framed connection, starting it if it is new
+ * @param w The worker owning the connection
+ * @param m The framed connection
+ * @param id The game id
+ * @return The game, or NULL if there are too many games
+ */
+static struct mux_game *mux_game(struct worker *w, struct mux *m, uint32_t id);
+
+/**
+ * @brief Remove a finished game of a framed connection
+ * @param m The framed connection
+ * @param g The game
+ */
+static void mux_remove(struct mux *m, struct mux_game *g);
+
+/**
+ * @brief Close a connection and free its state
+ * @param w The worker owning the connection
+ * @param c The connection
+ */
+static void close_conn(struct worker *w, struct conn *c);
+
+/**
+ * @brief Pick the secret of a new game
+ * @param w The worker (owns the generator state)
+ * @param secret Buffer receiving SLOTS colors
+ */
+static void new_secret(struct worker *w, uint8_t *secret);
+
+/**
+ * @brief Print the merged statistics of all workers
+ */
+static void print_stats(void);
+
+/**
+ * @brief Set O_NONBLOCK on a file descriptor
+ * @param fd The file descriptor
+ * @return 0 on success, -1 on error
+ */
+static int set_nonblocking(int fd);
 
 /**
  * @brief terminate program on program error
@@ -129,6 +372,12 @@ static void bail_out(int exitcode, const char *fmt, ...);
  */
 static void signal_handler(int sig);
 
+/**
+ * @brief Signal handler switching tracing on and off
+ * @param sig Signal number catched
+ */
+static void trace_signal_handler(int sig);
+
 /**
  * @brief free allocated resources
  */
@@ -137,74 +386,664 @@ static void free_resources(void);
 
 /* === Implementations === */
 
-static uint8_t *read_from_client(int fd, uint8_t *buffer, size_t n)
+static int set_nonblocking(int fd)
 {
-    /* loop, as packet can arrive in several partial reads */
-    size_t bytes_recv = 0;
-    do {
-        ssize_t r;
-        r = recv(fd, buffer + bytes_recv, n - bytes_recv, 0);
-        if (r <= 0) {
-            return NULL;
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void new_secret(struct worker *w, uint8_t *secret)
+{
+    const struct variant *v = &w->options->variant;
+
+    if (!w->options->random_secret) {
+        (void) memcpy(secret, w->options->secret, v->slots);
+        return;
+    }
+
+    /* xorshift64* */
+    w->rng_state ^= w->rng_state >> 12;
+    w->rng_state ^= w->rng_state << 25;
+    w->rng_state ^= w->rng_state >> 27;
+    uint64_t r = (w->rng_state * 2685821657736338717ULL) >> 32;
+    for (int j = 0; j < v->slots; ++j) {
+        secret[j] = r % v->colors;
+        r /= v->colors;
+    }
+}
+
+static uint8_t table_get(struct worker *w, const uint8_t *secret)
+{
+    struct answer_table *victim = NULL;
+    uint16_t key = 0;
+
+    if (w->options->variant.wide) {
+        return NO_TABLE;
+    }
+    for (int j = 0; j < SLOTS; ++j) {
+        key |= secret[j] << (j * SHIFT_WIDTH);
+    }
+    w->table_clock++;
+    for (int i = 0; i < TABLE_CACHE_SIZE; i++) {
+        struct answer_table *t = &w->tables[i];
+        if (t->answers != NULL && t->key == key) {
+            t->refs++;
+            t->last_use = w->table_clock;
+            return i;
+        }
+        if (t->refs == 0 && (victim == NULL || t->last_use < victim->last_use)) {
+            victim = t;
+        }
+    }
+
+    if (w->options->random_secret) {
+        int seen = 0;
+        for (int i = 0; i < RECENT_SECRETS; i++) {
+            seen |= (w->recent[i] == key);
+        }
+        if (!seen) {
+            w->recent[w->recent_pos] = key;
+            w->recent_pos = (w->recent_pos + 1) % RECENT_SECRETS;
+            return NO_TABLE;
+        }
+    }
+    if (victim == NULL) {
+        return NO_TABLE;
+    }
+    if (victim->answers == NULL
+        && (victim->answers = malloc(ANSWER_TABLE_SIZE)) == NULL) {
+        return NO_TABLE;
+    }
+    build_answer_table(secret, victim->answers);
+    victim->key = key;
+    victim->refs = 1;
+    victim->last_use = w->table_clock;
+    return victim - w->tables;
+}
+
+static void table_put(struct worker *w, uint8_t table)
+{
+    if (table != NO_TABLE) {
+        w->tables[table].refs--;
+    }
+}
+
+static int create_listener(const struct sockaddr_in *sin)
+{
+    int optval = 1;
+
+    /* every worker binds its own socket to the port; the kernel spreads
+       incoming connections among them */
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd == -1) {
+        bail_out(EXIT_FAILURE, "Error creating socket");
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof optval);
+    if(setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof optval) == -1) {
+        (void) close(fd);
+        bail_out(EXIT_FAILURE, "Error setting SO_REUSEPORT");
+    }
+
+    if(bind(fd, (const struct sockaddr*) sin, sizeof *sin) == -1) {
+        (void) close(fd);
+        bail_out(EXIT_FAILURE, "Error binding socket");
+    }
+
+    if(listen(fd, BACKLOG) == -1) {
+        (void) close(fd);
+        bail_out(EXIT_FAILURE, "Error listening for connections");
+    }
+
+    if(set_nonblocking(fd) == -1) {
+        (void) close(fd);
+        bail_out(EXIT_FAILURE, "Error setting socket non-blocking");
+    }
+    return fd;
+}
+
+static void create_unix_listener(const char *path)
+{
+    struct sockaddr_un sun;
+    struct stat st;
+
+    (void) memset(&sun, 0, sizeof sun);
+    sun.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof sun.sun_path) {
+        errno = 0;
+        bail_out(EXIT_FAILURE, "-u: socket path too long");
+    }
+    (void) strcpy(sun.sun_path, path);
+
+    if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        (void) unlink(path);
+    }
+    unixfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(unixfd == -1) {
+        bail_out(EXIT_FAILURE, "Error creating UNIX socket");
+    }
+    if(bind(unixfd, (const struct sockaddr*) &sun, sizeof sun) == -1) {
+        bail_out(EXIT_FAILURE, "Error binding UNIX socket");
+    }
+    unix_path = path;
+    if(listen(unixfd, BACKLOG) == -1) {
+        bail_out(EXIT_FAILURE, "Error listening for connections");
+    }
+    if(set_nonblocking(unixfd) == -1) {
+        bail_out(EXIT_FAILURE, "Error setting socket non-blocking");
+    }
+}
+
+static void setup_worker(struct worker *w, const struct sockaddr_in *sin,
+                         const struct sockaddr_in *muxsin)
+{
+    struct epoll_event ev;
+
+    w->epfd = epoll_create(MAX_EVENTS);
+    if(w->epfd == -1) {
+        bail_out(EXIT_FAILURE, "Error creating epoll instance");
+    }
+
+    w->sockfd = create_listener(sin);
+    ev.events = EPOLLIN;
+    ev.data.ptr = &w->sockfd;
+    if(epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->sockfd, &ev) == -1) {
+        bail_out(EXIT_FAILURE, "Error watching server socket");
+    }
+
+    /* the UNIX socket cannot be bound once per worker; they all watch the
+       same one, and EPOLLEXCLUSIVE wakes only one of them per connection */
+    if(unixfd >= 0) {
+        ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+        ev.data.ptr = &unixfd;
+        if(epoll_ctl(w->epfd, EPOLL_CTL_ADD, unixfd, &ev) == -1) {
+            bail_out(EXIT_FAILURE, "Error watching server socket");
+        }
+    }
+
+    if(muxsin != NULL) {
+        w->muxfd = create_listener(muxsin);
+        ev.events = EPOLLIN;
+        ev.data.ptr = &w->muxfd;
+        if(epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->muxfd, &ev) == -1) {
+            bail_out(EXIT_FAILURE, "Error watching server socket");
         }
-        bytes_recv += r;
-    } while (bytes_recv < n);
-    if (bytes_recv < n) {
-        return NULL;
     }
-    return buffer;
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = &wakeup[0];
+    if(epoll_ctl(w->epfd, EPOLL_CTL_ADD, wakeup[0], &ev) == -1) {
+        bail_out(EXIT_FAILURE, "Error watching wakeup pipe");
+    }
+}
+
+static void *run_worker(void *arg)
+{
+    struct worker *w = arg;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (!quit) {
+        int n = epoll_wait(w->epfd, events, MAX_EVENTS, -1);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            (void) fprintf(stderr, "%s: worker %d: epoll_wait: %s\n",
+                           progname, w->id, strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &w->sockfd) {
+                accept_games(w, w->sockfd, 0);
+            } else if (ptr == &w->muxfd) {
+                accept_games(w, w->muxfd, 1);
+            } else if (ptr == &unixfd) {
+                accept_games(w, unixfd, 0);
+            } else if (ptr == &wakeup[0]) {
+                /* the pipe is left readable, so every worker sees it */
+                continue;
+            } else if (((struct conn *) ptr)->reply_pending) {
+                handle_output(w, ptr);
+            } else {
+                handle_input(w, ptr);
+            }
+        }
+    }
+    return NULL;
 }
 
-static int compute_answer(uint16_t req, uint8_t *resp, uint8_t *secret)
+static void accept_games(struct worker *w, int listenfd, int framed)
 {
-    int colors_left[COLORS];
-    int guess[COLORS];
-    uint8_t parity_calc, parity_recv;
-    int red, white;
-    int j;
-
-    parity_recv = (req >> 15) & 1;
-
-    /* extract the guess and calculate parity */
-    parity_calc = 0;
-    for (j = 0; j < SLOTS; ++j) {
-        int tmp = req & 0x7;
-        parity_calc ^= tmp ^ (tmp >> 1) ^ (tmp >> 2);
-        guess[j] = tmp;
-        req >>= SHIFT_WIDTH;
-    }
-    parity_calc &= 0x1;
-
-    /* marking red and white */
-    (void) memset(&colors_left[0], 0, sizeof(colors_left));
-    red = white = 0;
-    for (j = 0; j < SLOTS; ++j) {
-        /* mark red */
-        if (guess[j] == secret[j]) {
-            red++;
+    for (;;) {
+        struct epoll_event ev;
+        struct conn *c;
+        int fd = accept(listenfd, NULL, 0);
+
+        if (fd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                DEBUG("accept: %s\n", strerror(errno));
+            }
+            return;
+        }
+        if (set_nonblocking(fd) == -1 || (c = calloc(1, sizeof *c)) == NULL) {
+            (void) close(fd);
+            continue;
+        }
+        /* replies are single small writes the client waits for; do not
+           let Nagle's algorithm hold them back */
+        if (listenfd != unixfd) {
+            int optval = 1;
+            (void) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof optval);
+        }
+        c->fd = fd;
+        c->serial = ++w->conn_serial;
+        if (framed) {
+            /* games are started by their first frame */
+            if ((c->mux = calloc(1, sizeof *c->mux)) == NULL) {
+                (void) close(fd);
+                free(c);
+                continue;
+            }
         } else {
-            colors_left[secret[j]]++;
+            new_secret(w, c->secret);
+            c->table = table_get(w, c->secret);
+        }
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            (void) close(fd);
+            if (!framed) {
+                table_put(w, c->table);
+            }
+            free(c->mux);
+            free(c);
+            continue;
+        }
+        c->next = w->conns;
+        if (w->conns != NULL) {
+            w->conns->prev = c;
+        }
+        w->conns = c;
+        if (!framed) {
+            w->stats.games++;
         }
     }
-    for (j = 0; j < SLOTS; ++j) {
-        /* not marked red */
-        if (guess[j] != secret[j]) {
-            if (colors_left[guess[j]] > 0) {
-                white++;
-                colors_left[guess[j]]--;
+}
+
+static void handle_input(struct worker *w, struct conn *c)
+{
+    if (c->mux != NULL) {
+        mux_input(w, c);
+        return;
+    }
+
+    /* a client may send several requests at once, or one in pieces */
+    while (!c->reply_pending && !c->done) {
+        size_t need = w->options->request_bytes;
+        ssize_t r = recv(c->fd, c->request + c->received,
+                         need - c->received, 0);
+        if (r == 0 || (r == -1 && errno != EAGAIN && errno != EWOULDBLOCK
+                                && errno != EINTR)) {
+            w->stats.aborted++;
+            close_conn(w, c);
+            return;
+        }
+        if (r == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        c->received += r;
+        if (c->received == need) {
+            uint32_t request = 0;
+            uint16_t reply;
+
+            /* little endian, 2 or 4 bytes */
+            while (c->received > 0) {
+                request = (request << 8) | c->request[--c->received];
             }
+            c->done = play_round(w, c, 0, &c->round, c->secret, c->table,
+                                 request, &reply);
+            if (send_reply(w, c, reply) == -1) {
+                c->done = 1;
+            }
+        }
+    }
+    if (c->done && !c->reply_pending) {
+        close_conn(w, c);
+    }
+}
+
+static void handle_output(struct worker *w, struct conn *c)
+{
+    struct epoll_event ev;
+
+    if (c->mux != NULL) {
+        int r = mux_flush(w, c);
+        if (r == -1) {
+            close_conn(w, c);
+        }
+        if (r != 0) {
+            return;
+        }
+    } else {
+        size_t len = w->options->reply_bytes;
+        ssize_t r = send(c->fd, c->reply + c->reply_sent,
+                         len - c->reply_sent, MSG_NOSIGNAL);
+
+        if (r == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
+        }
+        if (r <= 0) {
+            w->stats.aborted++;
+            close_conn(w, c);
+            return;
+        }
+        c->reply_sent += r;
+        if (c->reply_sent < len) {
+            return;
+        }
+        if (c->done) {
+            close_conn(w, c);
+            return;
+        }
+    }
+    c->reply_pending = 0;
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_MOD, c->fd, &ev) == -1) {
+        close_conn(w, c);
+        return;
+    }
+    handle_input(w, c);
+}
+
+static int play_round(struct worker *w, const struct conn *c, uint32_t game,
+                      uint8_t *round, const uint8_t *secret, uint8_t table,
+                      uint32_t request, uint16_t *reply)
+{
+    const struct variant *v = &w->options->variant;
+    int correct_guesses;
+    int parity_bit, lost_bit;
+    int done = 0;
+
+    ++*round;
+    w->stats.rounds++;
+    DEBUG("Worker %d, connection %u, game %u, round %d: Received 0x%x\n",
+          w->id, c->serial, game, *round, request);
+
+    /* compute answer */
+    if (v->wide) {
+        correct_guesses = compute_wide_answer(v, request, reply, secret);
+        parity_bit = WIDE_PARITY_ERR_BIT;
+        lost_bit = WIDE_GAME_LOST_ERR_BIT;
+    } else {
+        uint8_t resp;
+        if (table != NO_TABLE) {
+            correct_guesses = table_answer(w->tables[table].answers, request, &resp);
+        } else {
+            correct_guesses = compute_answer(request, &resp, secret);
         }
+        *reply = resp;
+        parity_bit = PARITY_ERR_BIT;
+        lost_bit = GAME_LOST_ERR_BIT;
+    }
+    if (*round == MAX_TRIES && correct_guesses != v->slots) {
+        *reply |= 1 << lost_bit;
+    }
+
+    DEBUG("Sending byte 0x%x\n", *reply);
+
+    if (trace_enabled) {
+        struct trace_record rec;
+        struct timespec ts;
+
+        (void) clock_gettime(CLOCK_REALTIME, &ts);
+        rec.ns = (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+        rec.conn = c->serial;
+        rec.game = game;
+        rec.worker = w->id;
+        rec.request = request;
+        rec.reply = *reply;
+        rec.round = *round;
+        (void) memset(rec.reserved, 0, sizeof rec.reserved);
+        trace_push(&w->trace, &rec);
     }
 
-    /* build response buffer */
-    resp[0] = red;
-    resp[0] |= (white << SHIFT_WIDTH);
-    if (parity_recv != parity_calc) {
-        resp[0] |= (1 << PARITY_ERR_BIT);
+    /* stop the game if it's over, or an error occured */
+    if (*reply & (1 << parity_bit)) {
+        DEBUG("Game %u: Parity error\n", game);
+        w->stats.parity_errors++;
+        done = 1;
+    }
+    if (*reply & (1 << lost_bit)) {
+        DEBUG("Game %u: Game lost\n", game);
+        w->stats.lost++;
+        done = 1;
+    }
+    if (correct_guesses == v->slots) {
+        DEBUG("Game %u: Runden: %d\n", game, *round);
+        w->stats.won++;
+        done = 1;
+    }
+    return done;
+}
+
+static int send_reply(struct worker *w, struct conn *c, uint16_t reply)
+{
+    struct epoll_event ev;
+    size_t len = w->options->reply_bytes;
+    ssize_t r;
+
+    c->reply[0] = reply & 0xff;
+    c->reply[1] = reply >> 8;
+    r = send(c->fd, c->reply, len, MSG_NOSIGNAL);
+    if (r == (ssize_t) len) {
+        return 0;
+    }
+    if (r == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
         return -1;
+    }
+
+    /* the client does not read its replies; wait until it does */
+    c->reply_sent = r > 0 ? r : 0;
+    c->reply_pending = 1;
+    ev.events = EPOLLOUT;
+    ev.data.ptr = c;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_MOD, c->fd, &ev) == -1) {
+        c->reply_pending = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static void mux_input(struct worker *w, struct conn *c)
+{
+    struct mux *m = c->mux;
+
+    while (!c->reply_pending) {
+        size_t off = 0;
+        ssize_t r = recv(c->fd, m->in + m->in_len, sizeof m->in - m->in_len, 0);
+        if (r == 0 || (r == -1 && errno != EAGAIN && errno != EWOULDBLOCK
+                                && errno != EINTR)) {
+            close_conn(w, c);
+            return;
+        }
+        if (r == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        m->in_len += r;
+
+        /* answer every complete frame; the replies are sent together */
+        while (m->in_len - off >= MUX_REQUEST_BYTES) {
+            const uint8_t *frame = m->in + off;
+            uint32_t id = mux_frame_id(frame);
+            struct mux_game *g = mux_game(w, m, id);
+            uint16_t reply;
+
+            if (g == NULL) {
+                DEBUG("Connection %d: too many games\n", c->fd);
+                close_conn(w, c);
+                return;
+            }
+            if (play_round(w, c, id, &g->round, g->secret, g->table,
+                           (frame[5] << 8) | frame[4], &reply)) {
+                table_put(w, g->table);
+                mux_remove(m, g);
+            }
+            mux_pack_reply(m->out + m->out_len, id, reply);
+            m->out_len += MUX_REPLY_BYTES;
+            off += MUX_REQUEST_BYTES;
+        }
+        m->in_len -= off;
+        (void) memmove(m->in, m->in + off, m->in_len);
+
+        if (mux_flush(w, c) == -1) {
+            close_conn(w, c);
+            return;
+        }
+    }
+}
+
+static int mux_flush(struct worker *w, struct conn *c)
+{
+    struct mux *m = c->mux;
+    struct epoll_event ev;
+
+    while (m->out_off < m->out_len) {
+        ssize_t r = send(c->fd, m->out + m->out_off, m->out_len - m->out_off,
+                         MSG_NOSIGNAL);
+        if (r == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return -1;
+            }
+            if (!c->reply_pending) {
+                /* the client does not read its replies; wait until it does */
+                c->reply_pending = 1;
+                ev.events = EPOLLOUT;
+                ev.data.ptr = c;
+                if (epoll_ctl(w->epfd, EPOLL_CTL_MOD, c->fd, &ev) == -1) {
+                    return -1;
+                }
+            }
+            return 1;
+        }
+        m->out_off += r;
+    }
+    m->out_off = m->out_len = 0;
+    return 0;
+}
+
+static struct mux_game *mux_game(struct worker *w, struct mux *m, uint32_t id)
+{
+    struct mux_game *g;
+    uint32_t i;
+
+    if (m->games != NULL) {
+        for (i = (id * 2654435761u) & m->mask; m->games[i].used;
+             i = (i + 1) & m->mask) {
+            if (m->games[i].id == id) {
+                return &m->games[i];
+            }
+        }
+    }
+    if (m->count >= MUX_MAX_GAMES) {
+        return NULL;
+    }
+
+    /* keep the table at most 3/4 full */
+    if (m->games == NULL || (m->count + 1) * 4 > (m->mask + 1) * 3) {
+        uint32_t size = m->games == NULL ? 8 : (m->mask + 1) * 2;
+        struct mux_game *old = m->games;
+        uint32_t old_size = m->games == NULL ? 0 : m->mask + 1;
+
+        if ((m->games = calloc(size, sizeof *m->games)) == NULL) {
+            m->games = old;
+            return NULL;
+        }
+        m->mask = size - 1;
+        for (uint32_t j = 0; j < old_size; j++) {
+            if (old[j].used) {
+                for (i = (old[j].id * 2654435761u) & m->mask; m->games[i].used;
+                     i = (i + 1) & m->mask)
+                    ;
+                m->games[i] = old[j];
+            }
+        }
+        free(old);
+    }
+
+    for (i = (id * 2654435761u) & m->mask; m->games[i].used;
+         i = (i + 1) & m->mask)
+        ;
+    g = &m->games[i];
+    g->id = id;
+    g->used = 1;
+    g->round = 0;
+    new_secret(w, g->secret);
+    g->table = table_get(w, g->secret);
+    m->count++;
+    w->stats.games++;
+    return g;
+}
+
+static void mux_remove(struct mux *m, struct mux_game *g)
+{
+    uint32_t hole = g - m->games;
+    uint32_t i = hole;
+
+    /* linear probing: move later entries of the cluster into the hole */
+    m->games[hole].used = 0;
+    m->count--;
+    for (;;) {
+        uint32_t home;
+        i = (i + 1) & m->mask;
+        if (!m->games[i].used) {
+            return;
+        }
+        home = (m->games[i].id * 2654435761u) & m->mask;
+        if (((i - home) & m->mask) >= ((i - hole) & m->mask)) {
+            m->games[hole] = m->games[i];
+            m->games[i].used = 0;
+            hole = i;
+        }
+    }
+}
+
+static void close_conn(struct worker *w, struct conn *c)
+{
+    /* closing the descriptor also removes it from the epoll set */
+    (void) close(c->fd);
+    if (c->prev != NULL) {
+        c->prev->next = c->next;
+    } else {
+        w->conns = c->next;
+    }
+    if (c->next != NULL) {
+        c->next->prev = c->prev;
+    }
+    if (c->mux != NULL) {
+        w->stats.aborted += c->mux->count;
+        for (uint32_t i = 0; c->mux->count > 0 && i <= c->mux->mask; i++) {
+            if (c->mux->games[i].used) {
+                table_put(w, c->mux->games[i].table);
+            }
+        }
+        free(c->mux->games);
+        free(c->mux);
     } else {
-        return red;
+        table_put(w, c->table);
     }
+    free(c);
 }
 
 static void bail_out(int exitcode, const char *fmt, ...)
@@ -230,35 +1069,103 @@ static void free_resources(void)
 {
     /* clean up resources */
     DEBUG("Shutting down server\n");
-    if(connfd >= 0) {
-        (void) close(connfd);
+    trace_stop();
+    for (int i = 0; i < num_workers; i++) {
+        struct worker *w = workers[i];
+        while (w->conns != NULL) {
+            close_conn(w, w->conns);
+        }
+        if(w->epfd >= 0) {
+            (void) close(w->epfd);
+        }
+        if(w->sockfd >= 0) {
+            (void) close(w->sockfd);
+        }
+        if(w->muxfd >= 0) {
+            (void) close(w->muxfd);
+        }
+        for (int j = 0; j < TABLE_CACHE_SIZE; j++) {
+            free(w->tables[j].answers);
+        }
+        trace_ring_free(&w->trace);
+        free(w);
+    }
+    free(workers);
+    workers = NULL;
+    num_workers = 0;
+    if(unixfd >= 0) {
+        (void) close(unixfd);
+        unixfd = -1;
+    }
+    if(unix_path != NULL) {
+        (void) unlink(unix_path);
+        unix_path = NULL;
     }
-    if(sockfd >= 0) {
-        (void) close(sockfd);
+    for (int i = 0; i < 2; i++) {
+        if(wakeup[i] >= 0) {
+            (void) close(wakeup[i]);
+            wakeup[i] = -1;
+        }
     }
 }
 
+static void print_stats(void)
+{
+    struct stats total;
+    unsigned long dropped = 0;
+
+    (void) memset(&total, 0, sizeof total);
+    for (int i = 0; i < num_workers; i++) {
+        const struct stats *st = &workers[i]->stats;
+        if (num_workers > 1) {
+            (void) printf("Worker %d: games: %lu, rounds: %lu\n",
+                          i, st->games, st->rounds);
+        }
+        total.games += st->games;
+        total.won += st->won;
+        total.lost += st->lost;
+        total.parity_errors += st->parity_errors;
+        total.aborted += st->aborted;
+        total.rounds += st->rounds;
+        dropped += workers[i]->trace.dropped;
+    }
+    (void) printf("Games: %lu, won: %lu, lost: %lu, parity errors: %lu, "
+                  "aborted: %lu, rounds: %lu\n", total.games, total.won,
+                  total.lost, total.parity_errors, total.aborted, total.rounds);
+    if (dropped > 0) {
+        (void) printf("Trace records dropped: %lu\n", dropped);
+    }
+}
+
+static void trace_signal_handler(int sig)
+{
+    trace_enabled = !trace_enabled;
+}
+
 static void signal_handler(int sig)
 {
+    int saved_errno = errno;
     quit = 1;
+    (void) write(wakeup[1], "q", 1);
+    errno = saved_errno;
 }
 
 /**
  * @brief Program entry point
+ * @detail Serves any number of concurrent games from one event loop per
+ * worker thread until SIGINT or SIGTERM is received; with -t, SIGUSR2
+ * switches tracing off and on
  * @param argc The argument counter
  * @param argv The argument vector
- * @return EXIT_SUCCESS on success, EXIT_PARITY_ERROR in case of an parity
- * error, EXIT_GAME_LOST in case client needed to many guesses,
- * EXIT_MULTIPLE_ERRORS in case multiple errors occured in one round
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
  */
 int main(int argc, char *argv[])
 {
 
     struct opts options;
-    int optval = 1;
-    int round;
-    int ret;
     struct sockaddr_in sin;
+    struct sockaddr_in muxsin;
+    sigset_t blocked, old;
     memset(&sin, 0, sizeof sin);
     
 
@@ -267,6 +1174,12 @@ int main(int argc, char *argv[])
     sin.sin_family = AF_INET;
     sin.sin_port  = htons(options.portno);  
     sin.sin_addr.s_addr = INADDR_ANY;
+    muxsin = sin;
+    muxsin.sin_port = htons(options.muxportno);
+
+    if(pipe(wakeup) == -1) {
+        bail_out(EXIT_FAILURE, "Error creating wakeup pipe");
+    }
 
     /* setup signal handlers */
     const int signals[] = {SIGINT, SIGTERM};
@@ -282,114 +1195,96 @@ int main(int argc, char *argv[])
             bail_out(EXIT_FAILURE, "sigaction");
         }
     }
-
-
-
-    /* Create a new TCP/IP socket `sockfd`, and set the SO_REUSEADDR
-       option for this socket. Then bind the socket to localhost:portno,
-       listen, and wait for new connections, which should be assigned to
-       `connfd`. Terminate the program in case of an error.
-    */
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if(sockfd == -1) {
-        bail_out(EXIT_FAILURE, "Error creating socket");
+    s.sa_handler = trace_signal_handler;
+    if(options.trace_path != NULL && sigaction(SIGUSR2, &s, NULL) < 0) {
+        bail_out(EXIT_FAILURE, "sigaction");
     }
-    setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof optval);
 
-    if(bind(sockfd, (struct sockaddr*) &sin, sizeof sin) == -1) {
-        bail_out(EXIT_FAILURE, "Error binding socket");
+    if(options.unix_path != NULL) {
+        create_unix_listener(options.unix_path);
     }
 
-    if(listen(sockfd, 5) == -1) {
-        bail_out(EXIT_FAILURE, "Error listening for connections");
-    }    
-
-    if((connfd = accept(sockfd, NULL, 0)) == -1) {
-        bail_out(EXIT_FAILURE, "Failed to accept connection");
+    /* Create non-blocking listening sockets and an epoll instance per
+       worker, all bound to localhost:portno (and localhost:muxportno). */
+    workers = calloc(options.workers, sizeof *workers);
+    if(workers == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating workers");
+    }
+    for(int i = 0; i < options.workers; i++) {
+        struct worker *w = calloc(1, sizeof *w);
+        if(w == NULL) {
+            bail_out(EXIT_FAILURE, "Error allocating worker");
+        }
+        w->id = i;
+        w->sockfd = -1;
+        w->muxfd = -1;
+        w->epfd = -1;
+        w->options = &options;
+        (void) memset(w->recent, 0xff, sizeof w->recent);
+        w->rng_state = ((uint64_t)time(NULL) << 32) ^ (uint64_t)getpid()
+                       ^ (0x9e3779b97f4a7c15ULL * (i + 1));
+        workers[num_workers++] = w;
+        setup_worker(w, &sin, options.muxportno != 0 ? &muxsin : NULL);
+        if(options.trace_path != NULL && trace_ring_init(&w->trace) == -1) {
+            bail_out(EXIT_FAILURE, "Error allocating trace ring");
+        }
     }
-    
 
-    /* accepted the connection */
-    ret = EXIT_SUCCESS;
-    for (round = 1; round <= MAX_TRIES && !quit; ++round) {
-        uint16_t request;
-        static uint8_t buffer[BUFFER_BYTES];
-        int correct_guesses;
-        int error = 0;
-
-        /* read from client */
-        if (read_from_client(connfd, &buffer[0], READ_BYTES) == NULL) {
-            if (quit) break; /* caught signal */
-            bail_out(EXIT_FAILURE, "read_from_client");
-        }
-        request = (buffer[1] << 8) | buffer[0];
-        DEBUG("Round %d: Received 0x%x\n", round, request);
-       
-        /* compute answer */
-        correct_guesses = compute_answer(request, buffer, options.secret);
-        if (round == MAX_TRIES && correct_guesses != SLOTS) {
-            buffer[0] |= 1 << GAME_LOST_ERR_BIT;
-        }
-
-        DEBUG("Sending byte 0x%x\n", buffer[0]);
-
-        /* send message to client */
-        send(connfd, buffer, sizeof buffer[0], 0);
-
-        /* We sent the answer to the client; now stop the game
-           if its over, or an error occured */
-        if (*buffer & (1<<PARITY_ERR_BIT)) {
-            (void) fprintf(stderr, "Parity error\n");
-            error = 1;
-            ret = EXIT_PARITY_ERROR;
-        }
-        if (*buffer & (1 << GAME_LOST_ERR_BIT)) {
-            (void) fprintf(stderr, "Game lost\n");
-            error = 1;
-            if (ret == EXIT_PARITY_ERROR) {
-                ret = EXIT_MULTIPLE_ERRORS;
-            } else {
-                ret = EXIT_GAME_LOST;
-            }
+    /* only the main thread handles signals; it wakes the workers */
+    if(sigemptyset(&blocked) < 0) {
+        bail_out(EXIT_FAILURE, "sigemptyset");
+    }
+    for(int i = 0; i < COUNT_OF(signals); i++) {
+        (void) sigaddset(&blocked, signals[i]);
+    }
+    (void) sigaddset(&blocked, SIGUSR2);
+    (void) pthread_sigmask(SIG_BLOCK, &blocked, &old);
+    if(options.trace_path != NULL) {
+        struct trace_ring *rings[num_workers];
+        for(int i = 0; i < num_workers; i++) {
+            rings[i] = &workers[i]->trace;
         }
-        if (error) {
-            break;
-        } else if (correct_guesses == SLOTS) {
-            /* won */
-            (void) printf("Runden: %d\n", round);
-            break;
+        if(trace_start(options.trace_path, rings, num_workers,
+                       options.variant.slots, options.variant.colors) == -1) {
+            bail_out(EXIT_FAILURE, "Error starting trace to %s",
+                     options.trace_path);
         }
     }
+    for(int i = 0; i < num_workers; i++) {
+        errno = pthread_create(&workers[i]->thread, NULL, run_worker, workers[i]);
+        if(errno != 0) {
+            quit = 1;
+            (void) write(wakeup[1], "q", 1);
+            for(int j = 0; j < i; j++) {
+                (void) pthread_join(workers[j]->thread, NULL);
+            }
+            bail_out(EXIT_FAILURE, "Error starting worker");
+        }
+    }
+    (void) pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    for(int i = 0; i < num_workers; i++) {
+        (void) pthread_join(workers[i]->thread, NULL);
+    }
 
     /* we are done */
+    trace_stop();
+    print_stats();
     free_resources();
-    return ret;
+    return EXIT_SUCCESS;
 }
 
-static void parse_args(int argc, char **argv, struct opts *options)
+static long int parse_port(const char *port_arg, const char *name)
 {
-    int i;
-    char *port_arg;
-    char *secret_arg;
     char *endptr;
-    enum { beige, darkblue, green, orange, red, black, violet, white };
-
-    if(argc > 0) {
-        progname = argv[0];
-    }
-    if (argc != 3) {
-        bail_out(EXIT_FAILURE,
-            "Usage: %s <server-port> <secret-sequence>", progname);
-    }
-    port_arg = argv[1];
-    secret_arg = argv[2];
+    long int portno;
 
     errno = 0;
-    options->portno = strtol(port_arg, &endptr, 10);
+    portno = strtol(port_arg, &endptr, 10);
 
     if ((errno == ERANGE &&
-          (options->portno == LONG_MAX || options->portno == LONG_MIN))
-        || (errno != 0 && options->portno == 0)) {
+          (portno == LONG_MAX || portno == LONG_MIN))
+        || (errno != 0 && portno == 0)) {
         bail_out(EXIT_FAILURE, "strtol");
     }
 
@@ -401,22 +1296,102 @@ static void parse_args(int argc, char **argv, struct opts *options)
 
     if (*endptr != '\0') { /* In principle not necessarily an error... */
         bail_out(EXIT_FAILURE,
-            "Further characters after <server-port>: %s", endptr);
-}
+            "Further characters after %s: %s", name, endptr);
+    }
 
     /* check for valid port range */
-    if (options->portno < 1 || options->portno > 65535)
+    if (portno < 1 || portno > 65535)
     {
         bail_out(EXIT_FAILURE, "Use a valid TCP/IP port range (1-65535)");
     }
+    return portno;
+}
+
+static void parse_args(int argc, char **argv, struct opts *options)
+{
+    int i;
+    int c;
+    char *secret_arg;
+    char *endptr;
+    enum { beige, darkblue, green, orange, red, black, violet, white };
+
+    if(argc > 0) {
+        progname = argv[0];
+    }
+    options->workers = 1;
+    options->muxportno = 0;
+    options->unix_path = NULL;
+    options->trace_path = NULL;
+    (void) variant_init(&options->variant, SLOTS, COLORS);
+    while ((c = getopt(argc, argv, "w:m:u:t:v:")) != -1) {
+        switch (c) {
+        case 'm':
+            options->muxportno = parse_port(optarg, "-m");
+            break;
+        case 't':
+            options->trace_path = optarg;
+            break;
+        case 'u':
+            options->unix_path = optarg;
+            break;
+        case 'v':
+            if (parse_variant(optarg, &options->variant) == -1) {
+                errno = 0;
+                bail_out(EXIT_FAILURE, "-v needs <pins>x<colors>, at most %dx%d",
+                         MAX_SLOTS, MAX_COLORS);
+            }
+            break;
+        case 'w':
+            errno = 0;
+            options->workers = strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || *endptr != '\0'
+                || options->workers < 1 || options->workers > 1024) {
+                bail_out(EXIT_FAILURE, "-w needs a number of workers (1-1024)");
+            }
+            break;
+        default:
+            errno = 0;
+            bail_out(EXIT_FAILURE,
+                "Usage: %s [-w <workers>] [-m <framed-port>] [-u <socket-path>] "
+            "[-t <trace-file>] [-v <pins>x<colors>] <server-port> "
+            "[<secret-sequence>]",
+                progname);
+        }
+    }
+    if (argc - optind != 1 && argc - optind != 2) {
+        errno = 0;
+        bail_out(EXIT_FAILURE,
+            "Usage: %s [-w <workers>] [-m <framed-port>] [-u <socket-path>] "
+            "[-t <trace-file>] [-v <pins>x<colors>] <server-port> "
+            "[<secret-sequence>]",
+            progname);
+    }
+    options->portno = parse_port(argv[optind], "<server-port>");
+    secret_arg = argc - optind == 2 ? argv[optind + 1] : NULL;
+    if (options->portno == options->muxportno) {
+        errno = 0;
+        bail_out(EXIT_FAILURE, "-m needs a port different from <server-port>");
+    }
+    if (options->muxportno != 0 && options->variant.wide) {
+        errno = 0;
+        bail_out(EXIT_FAILURE, "-m is only supported for %dx%d", SLOTS, COLORS);
+    }
+    options->request_bytes = options->variant.wide ? WIDE_REQUEST_BYTES : 2;
+    options->reply_bytes = options->variant.wide ? WIDE_REPLY_BYTES : 1;
 
-    if (strlen(secret_arg) != SLOTS) {
+    /* without a secret every game gets a random one */
+    options->random_secret = (secret_arg == NULL);
+    if (options->random_secret) {
+        return;
+    }
+
+    if (strlen(secret_arg) != options->variant.slots) {
         bail_out(EXIT_FAILURE,
-            "<secret-sequence> has to be %d chars long", SLOTS);
+            "<secret-sequence> has to be %d chars long", options->variant.slots);
     }
 
-    /* read secret */
-    for (i = 0; i < SLOTS; ++i) {
+    /* read secret; colors without a letter only appear in random secrets */
+    for (i = 0; i < options->variant.slots; ++i) {
         uint8_t color;
         switch (secret_arg[i]) {
         case 'b':
@@ -447,6 +1422,10 @@ static void parse_args(int argc, char **argv, struct opts *options)
             bail_out(EXIT_FAILURE,
                 "Bad Color '%c' in <secret-sequence>", secret_arg[i]);
         }
+        if (color >= options->variant.colors) {
+            bail_out(EXIT_FAILURE,
+                "Bad Color '%c' in <secret-sequence>", secret_arg[i]);
+        }
         options->secret[i] = color;
     }
 }
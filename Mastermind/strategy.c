@@ -3,166 +3,721 @@
 * @author Michael Reitgruber
 * @date 22.10.2015
 * @brief Implements the strategy for the Mastermind Client
-* @details Contains a basic elimination approach strategy for Mastermind
+* @details Contains a basic elimination approach strategy for Mastermind. All state of a game lives in its solver,
+*          so one process can solve any number of games at the same time. The codes still possible are kept in a
+*          bitset, one bit per code, which bounds the memory of a solver to colors^pins bits; elimination only
+*          visits the set bits. Once few enough codes are left they are listed instead and partitioned by the reply
+*          they give to the current guess, so the reply of the server just selects a partition. The partition sizes
+*          also rate guesses for the minimax and entropy strategies, which keep the partition of the guess they pick:
+*          every candidate is scored against a played guess once.
+*          Built with STRATEGY_STATS, every solver_next() call is recorded by round: the candidates before and after
+*          the elimination, the number of candidates scored and the time taken. The totals of all solvers of the
+*          process are printed by solver_stats_dump() and, at the next solver_next() call, after a SIGUSR1.
 */
 
 #include "strategy.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <math.h>
+#ifdef STRATEGY_STATS
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#endif
 #define COLORS (8)
 #define PINS (5)
-#define SOLUTION_SIZE (8*8*8*8*8)
+#define MAX_COLORS (16)
 
-enum color {beige = 0, darkblue, green, orange, red, black, violet, white};
+/*Largest number of codes a solver supports*/
+#define MAX_CODES (1u << 31)
 
-//array containing all possible guesses
-static guess *all[SOLUTION_SIZE];
+/*Candidates are listed and partitioned once at most this many are left*/
+#define LIST_LIMIT (1u << 20)
 
-static guess *current_guess;
+/*Number of different replies, red * (MAX_PINS + 1) + white*/
+#define MAX_REPLIES ((MAX_PINS + 1) * (MAX_PINS + 1))
 
-void copy_pattern(guess *a, guess *b);
+/*Number of candidates the minimax and entropy strategies try as the next guess at most*/
+#define GUESS_POOL (256)
+
+/*Number of candidates scored to choose one guess at most; fewer are tried when many are left*/
+#define SCORE_BUDGET (1L << 18)
+
+#ifdef STRATEGY_STATS
+/*Rounds recorded separately, later ones are added to the last*/
+#define STAT_ROUNDS (16)
+
+/*Counts candidates scored by a solver*/
+#define COUNT_SCORED(s, n) ((s)->scored += (n))
+
+//What the solver_next() calls of one round took
+struct round_stats {
+    long calls;
+    long long before;       //candidates before the elimination
+    long long after;        //candidates after the elimination
+    long long scored;       //candidates scored against a guess
+    long long ns;
+    long long max_ns;
+};
+
+//the totals of all solvers
+static struct round_stats stats[STAT_ROUNDS];
+static long stats_solvers = 0;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+//set by SIGUSR1
+static volatile sig_atomic_t stats_requested = 0;
+
+/**
+ * @brief Signal handler requesting a dump of the statistics
+ * @param sig The signal
+ */
+static void request_stats(int sig);
+#else
+#define COUNT_SCORED(s, n) ((void)0)
+#endif
+
+//State of one game
+struct solver {
+    guess current;          //the guess to play next
+    int pins;
+    int colors;
+    uint32_t codes;         //colors^pins
+    uint32_t words;         //length of bits
+    uint32_t first;         //words before this one are empty
+    long count;             //number of candidates
+    uint64_t *bits;         //bit i is set if code i is still possible, NULL once the candidates are listed
+    enum solver_strategy strategy;
+    uint32_t *list;         //candidates list[base] to list[base + count - 1], 4 bits per pin, first pin lowest
+    uint32_t *spare;        //receives the next partition
+    uint8_t *reply;         //reply of every candidate to the current guess
+    uint8_t *scratch;       //replies to the guess being rated
+    uint32_t base;
+    int partitioned;        //whether spare holds the candidates partitioned by their reply to the current guess
+    uint32_t start[MAX_REPLIES + 1];  //partition of a reply in spare
+#ifdef STRATEGY_STATS
+    int round;              //number of solver_next() calls
+    long long scored;
+#endif
+};
+
+/**
+ * @brief Converts a code to a pattern
+ * @detail A code is the index of a pattern in the list of all patterns, the first pin is the most significant digit
+ * @param s The solver
+ * @param code The code
+ * @param pattern Receives the colors of the pins
+ */
+static void decode(const solver *s, uint32_t code, int *pattern);
+
+/**
+ * @brief Moves a pattern forward to a later code
+ * @param s The solver
+ * @param pattern The colors of the pins, updated
+ * @param delta Difference between the new and the old code
+ */
+static void advance(const solver *s, int *pattern, uint32_t delta);
+
+/**
+ * @brief Checks whether a pattern would have produced the reply the server gave for the current guess
+ * @param s The solver
+ * @param guess_colors Number of pins of every color in the current guess
+ * @param pattern The pattern
+ * @param red Number of red pins returned on the guess
+ * @param white Number of white pins returned on the guess
+ * @return 1 if the pattern is still possible, 0 else
+ */
+static int consistent(const solver *s, const int *guess_colors, const int *pattern, int red, int white);
+
+/**
+ * @brief Computes the reply a listed candidate gives to a guess
+ * @param s The solver
+ * @param pattern The guess
+ * @param guess_colors Number of pins of every color in the guess
+ * @param packed The candidate, 4 bits per pin
+ * @return red * (pins + 1) + white
+ */
+static inline int score(const solver *s, const int *pattern, const int *guess_colors, uint32_t packed);
+
+/**
+ * @brief Replaces the bitset by a list of the candidates
+ * @param s The solver
+ * @return 0 on success, -1 if no memory is available, the bitset is kept then
+ */
+static int list_candidates(solver *s);
+
+/**
+ * @brief Scores every candidate against a guess
+ * @param s The solver
+ * @param pattern The guess
+ * @param replies Receives the reply of every candidate
+ * @param sizes Receives the number of candidates giving each reply
+ */
+static void score_all(solver *s, const int *pattern, uint8_t *replies, uint32_t *sizes);
 
 /**
- * @brief Initialise necessary variables and setup Strategy
- * @detail Populizes an array containing all possible combinations of colors, which will be used to determine the solution by eliminating invalid guesses
- * @param start_guess An int array containing the initial guess to seed the next_guess function
- * @return A pointer to the currently selected guess (directly after calling this method it will be equal to the initial guess)
+ * @brief Sorts the candidates into spare by their reply to the current guess
+ * @param s The solver
+ * @param sizes Number of candidates giving each reply
+ */
+static void partition(solver *s, const uint32_t *sizes);
+
+/**
+ * @brief Selects the guess to play next among the listed candidates
+ * @detail The first strategy plays the first candidate, the others try a pool of candidates spread evenly over the
+ *         list, as large as SCORE_BUDGET allows, and partition the candidates by the best one
+ * @param s The solver
+ */
+static void choose_guess(solver *s);
+
+/**
+ * @brief Eliminates the candidates not matching the reply and selects the next guess
+ * @param s The solver
+ * @param red Number of red pins returned on last guess
+ * @param white Number of white pins returned on last guess
+ * @return The next guess to be played, or NULL if no candidate is left
+ */
+static const guess *next_guess(solver *s, int red, int white);
+
+/**
+ * @brief Creates the state of one game with 5 pins and 8 colors
+ * @param start_guess An int array containing the first guess to play
+ * @return The solver, or NULL if no memory is available
 */
-guess *init_strat(int start_guess[]) {
-    current_guess = malloc(sizeof(guess));
-    int first = 8*8*8*8;
-    int second = 8*8*8;
-    int third = 8*8;
-    int fourth = 8;
-    
-    for(int h=0; h<PINS; h++) {
-        current_guess->pattern[h] = start_guess[h];
-    }    
-    for(int i=0; i<COLORS; i++) {
-        for(int j=0; j<COLORS; j++) {
-            for(int k=0; k<COLORS; k++) {
-                for(int l=0; l<COLORS; l++) {
-                    for(int m=0; m<COLORS; m++) {
-                        fill(first*i+second*j+third*k+fourth*l+m, i, j, k, l, m);
-                    }
-                }
-            }
-        }
+solver *solver_new(const int *start_guess)
+{
+    return solver_new_variant(PINS, COLORS, start_guess);
+}
+
+/**
+ * @brief Creates the state of one game
+ * @param pins Number of pins (1-MAX_PINS)
+ * @param colors Number of colors (2-16)
+ * @param start_guess An int array containing the first guess to play, or NULL for pairs of the first colors
+ *        (0 0 1 1 2 ...)
+ * @return The solver, or NULL if the variant is not supported or no memory is available
+*/
+solver *solver_new_variant(int pins, int colors, const int *start_guess)
+{
+    uint64_t codes = 1;
+    solver *s;
+
+    if(pins < 1 || pins > MAX_PINS || colors < 2 || colors > MAX_COLORS) {
+        return NULL;
+    }
+    for(int i=0; i<pins; i++) {
+        codes *= colors;
+    }
+    if(codes > MAX_CODES || (s = malloc(sizeof *s)) == NULL) {
+        return NULL;
+    }
+    s->pins = pins;
+    s->colors = colors;
+    s->codes = codes;
+    s->words = (codes + 63) / 64;
+    s->first = 0;
+    s->count = codes;
+    s->strategy = STRATEGY_FIRST;
+    s->list = s->spare = NULL;
+    s->reply = s->scratch = NULL;
+    s->base = 0;
+    s->partitioned = 0;
+#ifdef STRATEGY_STATS
+    s->round = 0;
+    s->scored = 0;
+    (void) pthread_mutex_lock(&stats_lock);
+    stats_solvers++;
+    (void) pthread_mutex_unlock(&stats_lock);
+#endif
+    if((s->bits = malloc(s->words * sizeof *s->bits)) == NULL) {
+        free(s);
+        return NULL;
+    }
+    (void) memset(s->bits, 0xff, s->words * sizeof *s->bits);
+    if(codes % 64 != 0) {
+        s->bits[s->words - 1] = (UINT64_C(1) << (codes % 64)) - 1;
     }
-    return current_guess;
+    (void) memset(&s->current, 0, sizeof s->current);
+    for(int i=0; i<pins; i++) {
+        s->current.pattern[i] = start_guess != NULL ? start_guess[i] : (i / 2) % colors;
+    }
+    /* small variants are partitioned from the first reply on, larger ones once enough codes are eliminated */
+    if(codes <= LIST_LIMIT) {
+        (void) list_candidates(s);
+    }
+    return s;
 }
 
 /**
- * @brief Fills one guess at the index idx with colors c1-5
- * @param idx The index of the guess to fill
- * @param c1 Color of first pin
- * @param c2 Color of second pin
- * @param c3 Color of third pin
- * @param c4 Color of fourth pin
- * @param c5 Color of fifth pin
+ * @brief Selects how the guesses after the first one are chosen
+ * @param s The solver
+ * @param strategy The strategy
 */
-void fill(int idx, int c1, int c2, int c3, int c4, int c5) 
-{   
-    all[idx] = malloc(sizeof(guess));
-    all[idx]->pattern[0] = c1;
-    all[idx]->pattern[1] = c2;
-    all[idx]->pattern[2] = c3;
-    all[idx]->pattern[3] = c4;
-    all[idx]->pattern[4] = c5;   
-}
-
-/*
- *@brief plays two guesses against each other using the same method as the server (Credit to OSUE-Team)
- *@detail This is used to determine which guesses to remove from the list. 
- *@param a The guess that will emulate being the solution
- *@param b The guess that will play against the "solution" (guess a)
- *@param res An array containing the number of red pins(res[0]) and white pins(res[1])
+void solver_set_strategy(solver *s, enum solver_strategy strategy)
+{
+    s->strategy = strategy;
+}
+
+/**
+ * @brief Looks up a strategy by its name
+ * @param name "first", "minimax" or "entropy"
+ * @param strategy Receives the strategy
+ * @return 0 on success, -1 if there is no such strategy
 */
-void play_against(guess *a, guess *b, int *res)
-{   int colors_left[COLORS];
-    int red,white;
-    int j;
-
-    /* marking red and white */
-    (void) memset(&colors_left[0], 0, sizeof(colors_left));
-    red = white = 0;
-    for (j = 0; j < PINS; ++j) {
-        /* mark red */
-        if (b->pattern[j] == a->pattern[j]) {
-            red++;
-        } else {
-            colors_left[a->pattern[j]]++;
-        }
-    }
-    for (j = 0; j < PINS; ++j) {
-        /* not marked red */
-        if (b->pattern[j] != a->pattern[j]) {
-            if (colors_left[b->pattern[j]] > 0) {
-                white++;
-                colors_left[b->pattern[j]]--;
+int parse_strategy(const char *name, enum solver_strategy *strategy)
+{
+    static const char *names[] = {"first", "minimax", "entropy"};
+
+    for(int i=0; i<(int)(sizeof names / sizeof names[0]); i++) {
+        if(strcmp(name, names[i]) == 0) {
+            *strategy = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Reads the best opening from a table written by the opening tool
+ * @detail The table starts with the variant (<pins>x<colors>), followed by one opening per line, best first; an
+ *         opening has one hex digit per pin. Lines starting with # are skipped.
+ * @param path The table
+ * @param pins Number of pins the opening has to have
+ * @param colors Number of colors the opening may use
+ * @param pattern Receives the opening
+ * @return 0 on success, -1 on error with errno set (EINVAL if the table is malformed or of another variant)
+*/
+int load_opening(const char *path, int pins, int colors, int *pattern)
+{
+    char line[256];
+    int p, c, found = 0;
+    FILE *f;
+
+    if((f = fopen(path, "r")) == NULL) {
+        return -1;
+    }
+    while(found < 2 && fgets(line, sizeof line, f) != NULL) {
+        if(line[0] == '#') {
+            continue;
+        }
+        if(found++ == 0) {
+            if(sscanf(line, "%dx%d", &p, &c) != 2 || p != pins || c != colors) {
+                break;
             }
+            continue;
+        }
+        for(p=0; p<pins; p++) {
+            const char *digit = line[p] != '\0' ? strchr("0123456789abcdef", line[p]) : NULL;
+            if(digit == NULL || digit - "0123456789abcdef" >= colors) {
+                break;
+            }
+            pattern[p] = digit - "0123456789abcdef";
+        }
+        if(p != pins || (line[p] != ' ' && line[p] != '\n' && line[p] != '\0')) {
+            found = 0;
         }
     }
-    res[0] = red;
-    res[1] = white;
+    (void) fclose(f);
+    if(found < 2) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the guess to play next
+ * @param s The solver
+ * @return The guess, valid until the next call to solver_next() or solver_free()
+*/
+const guess *solver_guess(const solver *s)
+{
+    return &s->current;
+}
+
+/**
+ * @brief Returns the number of codes which are still possible
+ * @param s The solver
+ * @return Number of candidates
+*/
+long solver_candidates(const solver *s)
+{
+    return s->count;
 }
 
 /**
- * @brief Copies the pattern from one guess to another
+ * @brief Frees the state of a game
+ * @param s The solver
 */
-void copy_pattern(guess *a, guess *b) 
+void solver_free(solver *s)
+{
+    if(s != NULL) {
+        free(s->bits);
+        free(s->list);
+        free(s->spare);
+        free(s->reply);
+        free(s->scratch);
+        free(s);
+    }
+}
+
+static void decode(const solver *s, uint32_t code, int *pattern)
+{
+    for(int i=s->pins-1; i>=0; i--) {
+        pattern[i] = code % s->colors;
+        code /= s->colors;
+    }
+}
+
+static void advance(const solver *s, int *pattern, uint32_t delta)
+{
+    for(int i=s->pins-1; i>=0 && delta > 0; i--) {
+        delta += pattern[i];
+        pattern[i] = delta % s->colors;
+        delta /= s->colors;
+    }
+}
+
+static int consistent(const solver *s, const int *guess_colors, const int *pattern, int red, int white)
+{
+    int colors[MAX_COLORS] = {0};
+    int r = 0, common = 0;
+
+    for(int i=0; i<s->pins; i++) {
+        r += (pattern[i] == s->current.pattern[i]);
+        colors[pattern[i]]++;
+    }
+    if(r != red) {
+        return 0;
+    }
+    /* every color in common is either a red or a white pin */
+    for(int c=0; c<s->colors; c++) {
+        common += colors[c] < guess_colors[c] ? colors[c] : guess_colors[c];
+    }
+    return common - r == white;
+}
+
+static inline int score(const solver *s, const int *pattern, const int *guess_colors, uint32_t packed)
+{
+    uint8_t colors[MAX_COLORS] = {0};
+    int red = 0, common = 0;
+
+    for(int i=0; i<s->pins; i++, packed >>= 4) {
+        int c = packed & 0xf;
+        red += (c == pattern[i]);
+        /* the n-th pin of a color is in common if the guess has at least n pins of it */
+        common += (colors[c]++ < guess_colors[c]);
+    }
+    return red * (s->pins + 1) + common - red;
+}
+
+static int list_candidates(solver *s)
+{
+    uint32_t n = 0;
+
+    s->list = malloc(s->count * sizeof *s->list);
+    s->spare = malloc(s->count * sizeof *s->spare);
+    s->reply = malloc(s->count);
+    s->scratch = malloc(s->count);
+    if(s->list == NULL || s->spare == NULL || s->reply == NULL || s->scratch == NULL) {
+        free(s->list);
+        free(s->spare);
+        free(s->reply);
+        free(s->scratch);
+        s->list = s->spare = NULL;
+        s->reply = s->scratch = NULL;
+        return -1;
+    }
+    if(s->count == s->codes) {
+        /* count through all patterns, the last pin fastest as in the codes */
+        uint32_t packed = 0;
+        for(n=0; n<s->codes; n++) {
+            int i = s->pins - 1;
+            s->list[n] = packed;
+            while(i > 0 && ((packed >> (4 * i)) & 0xf) == (uint32_t)s->colors - 1) {
+                packed &= ~(UINT32_C(0xf) << (4 * i));
+                i--;
+            }
+            packed += UINT32_C(1) << (4 * i);
+        }
+    }
+    for(uint32_t w=s->first; s->count != s->codes && w<s->words; w++) {
+        uint64_t word = s->bits[w];
+        uint32_t prev;
+        int pattern[MAX_PINS];
+
+        if(word == 0) {
+            continue;
+        }
+        prev = w * 64 + __builtin_ctzll(word);
+        decode(s, prev, pattern);
+        for(; word != 0; word &= word - 1) {
+            uint32_t packed = 0;
+            advance(s, pattern, w * 64 + __builtin_ctzll(word) - prev);
+            prev = w * 64 + __builtin_ctzll(word);
+            for(int i=s->pins-1; i>=0; i--) {
+                packed = packed << 4 | pattern[i];
+            }
+            s->list[n++] = packed;
+        }
+    }
+    free(s->bits);
+    s->bits = NULL;
+    s->base = 0;
+    return 0;
+}
+
+static void score_all(solver *s, const int *pattern, uint8_t *replies, uint32_t *sizes)
 {
-    for(int i=0; i<PINS; i++) {
-        a->pattern[i] = b->pattern[i];
+    int guess_colors[MAX_COLORS] = {0};
+    const uint32_t *list = s->list + s->base;
+
+    for(int i=0; i<s->pins; i++) {
+        guess_colors[pattern[i]]++;
+    }
+    (void) memset(sizes, 0, MAX_REPLIES * sizeof *sizes);
+    COUNT_SCORED(s, s->count);
+    for(long i=0; i<s->count; i++) {
+        replies[i] = score(s, pattern, guess_colors, list[i]);
+        sizes[replies[i]]++;
+    }
+}
+
+static void partition(solver *s, const uint32_t *sizes)
+{
+    uint32_t next[MAX_REPLIES];
+    const uint32_t *list = s->list + s->base;
+
+    s->start[0] = 0;
+    for(int r=0; r<MAX_REPLIES; r++) {
+        next[r] = s->start[r];
+        s->start[r + 1] = s->start[r] + sizes[r];
+    }
+    /* stable, so every partition keeps the candidates in ascending order */
+    for(long i=0; i<s->count; i++) {
+        s->spare[next[s->reply[i]]++] = list[i];
+    }
+    s->partitioned = 1;
+}
+
+static void choose_guess(solver *s)
+{
+    uint32_t best_sizes[MAX_REPLIES];
+    uint32_t best = s->base;
+    double best_rating = HUGE_VAL;
+    uint32_t pool = s->count < GUESS_POOL ? s->count : GUESS_POOL;
+
+    if(pool * s->count > SCORE_BUDGET) {
+        pool = SCORE_BUDGET / s->count > 0 ? SCORE_BUDGET / s->count : 1;
+    }
+    s->partitioned = 0;
+    if(s->strategy == STRATEGY_FIRST || s->count == 1) {
+        pool = 0;
+    }
+    for(uint32_t p=0; p<pool; p++) {
+        uint32_t candidate = s->base + (uint64_t)p * s->count / pool;
+        uint32_t sizes[MAX_REPLIES];
+        double rating = 0;
+        int pattern[MAX_PINS];
+
+        for(int i=0; i<s->pins; i++) {
+            pattern[i] = (s->list[candidate] >> (4 * i)) & 0xf;
+        }
+        score_all(s, pattern, s->scratch, sizes);
+        for(int r=0; r<MAX_REPLIES; r++) {
+            if(s->strategy == STRATEGY_MINIMAX) {
+                rating = sizes[r] > rating ? sizes[r] : rating;
+            } else if(sizes[r] > 1) {
+                /* minimizing the sum of n log n maximizes the entropy of the reply */
+                rating += sizes[r] * log2(sizes[r]);
+            }
+        }
+        if(rating < best_rating) {
+            uint8_t *tmp = s->reply;
+            s->reply = s->scratch;
+            s->scratch = tmp;
+            (void) memcpy(best_sizes, sizes, sizeof best_sizes);
+            best_rating = rating;
+            best = candidate;
+        }
+    }
+    for(int i=0; i<s->pins; i++) {
+        s->current.pattern[i] = (s->list[best] >> (4 * i)) & 0xf;
+    }
+    if(pool > 0) {
+        partition(s, best_sizes);
     }
 }
 
 /**
  * @brief Returns the next guess to play against the server
- * @detail First eliminates unwanted guesses via the eliminate function, then selects the first valid guess from the remaining
+ * @detail Eliminates all candidates which do not give the same number of red and white pins against the current guess
+ *         as the server did, then selects the next guess among the remaining candidates
+ * @param s The solver
  * @param red Number of red pins returned on last guess
  * @param white Number of white pins returned on last guess
- * @return The next guess to be played
+ * @return The next guess to be played, or NULL if no candidate is left
 */
-guess *next_guess(int red, int white)
+const guess *solver_next(solver *s, int red, int white)
 {
-   eliminate(red, white);
-   for(int i=0; i<SOLUTION_SIZE; i++) {
-       if(all[i] != NULL) {
-           copy_pattern(current_guess,all[i]);
-           return all[i];
-       }
-   }
-   return NULL; 
+#ifdef STRATEGY_STATS
+    struct timespec t0, t1;
+    long before = s->count;
+    const guess *next;
+    struct round_stats *rs = &stats[s->round < STAT_ROUNDS - 1 ? s->round : STAT_ROUNDS - 1];
+    long long ns;
+
+    s->round++;
+    s->scored = 0;
+    (void) clock_gettime(CLOCK_MONOTONIC, &t0);
+    next = next_guess(s, red, white);
+    (void) clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = (t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec);
+
+    (void) pthread_mutex_lock(&stats_lock);
+    rs->calls++;
+    rs->before += before;
+    rs->after += s->count;
+    rs->scored += s->scored;
+    rs->ns += ns;
+    if(ns > rs->max_ns) {
+        rs->max_ns = ns;
+    }
+    (void) pthread_mutex_unlock(&stats_lock);
+    if(stats_requested) {
+        stats_requested = 0;
+        solver_stats_dump(stderr);
+    }
+    return next;
+#else
+    return next_guess(s, red, white);
+#endif
 }
 
+#ifdef STRATEGY_STATS
 /**
- * @brief Eliminates all invalid guesses from the global array
- * @detail Plays the current guess against all remaining guesses. All guesses which do not return the same number of red an white pins as the server
- *         can not be valid. 
- * @param red Number of red pins returned on last guess
- * @param white Number of white pins returned on last guess
+ * @brief Prints the statistics of all solvers of the process, averaged per round
+ * @detail Prints nothing if no solver was created
+ * @param out The stream
 */
-void eliminate(int red, int white) {
-    static int buff[2];
-    for(int i=0; i<SOLUTION_SIZE; i++) { 
-        if(all[i] != NULL) {
-            play_against(current_guess, all[i], buff);
-        }
-        if(buff[0] != red || buff[1] != white) {
-            free(all[i]);
-            all[i] = NULL;
+void solver_stats_dump(FILE *out)
+{
+    (void) pthread_mutex_lock(&stats_lock);
+    if(stats_solvers == 0) {
+        (void) pthread_mutex_unlock(&stats_lock);
+        return;
+    }
+    (void) fprintf(out, "strategy stats: %ld solvers\n", stats_solvers);
+    (void) fprintf(out, "round     calls  before avg   after avg  scored avg   mean us    max us\n");
+    for(int r=0; r<STAT_ROUNDS; r++) {
+        const struct round_stats *rs = &stats[r];
+        if(rs->calls == 0) {
+            continue;
         }
+        (void) fprintf(out, "%3d%s %9ld %11.1f %11.1f %11.1f %9.2f %9.2f\n", r + 1, r == STAT_ROUNDS - 1 ? "+" : " ",
+                       rs->calls, (double)rs->before / rs->calls, (double)rs->after / rs->calls,
+                       (double)rs->scored / rs->calls, rs->ns / 1e3 / rs->calls, rs->max_ns / 1e3);
     }
-
+    (void) pthread_mutex_unlock(&stats_lock);
 }
 
 /**
- * @brief Used to free the remaining space allocated by the global array
+ * @brief Makes SIGUSR1 print the statistics at the next solver_next() call
+ * @return 0 on success, -1 on error
 */
-void free_all() {
-    for(int i=0; i<SOLUTION_SIZE; i++) {
-        free(all[i]);
+int solver_stats_signal(void)
+{
+    struct sigaction sa;
+
+    (void) memset(&sa, 0, sizeof sa);
+    sa.sa_handler = request_stats;
+    sa.sa_flags = SA_RESTART;
+    return sigaction(SIGUSR1, &sa, NULL);
+}
+
+static void request_stats(int sig)
+{
+    (void) sig;
+    stats_requested = 1;
+}
+#endif
+
+static const guess *next_guess(solver *s, int red, int white)
+{
+    int guess_colors[MAX_COLORS] = {0};
+    uint32_t first = s->words;
+    long count = 0;
+
+    if(s->bits == NULL) {
+        int r = red * (s->pins + 1) + white;
+        uint32_t *tmp;
+
+        if(red < 0 || white < 0 || red + white > s->pins) {
+            s->count = 0;
+            return NULL;
+        }
+        if(!s->partitioned) {
+            uint32_t sizes[MAX_REPLIES];
+            score_all(s, s->current.pattern, s->reply, sizes);
+            partition(s, sizes);
+        }
+        /* the candidates giving the reply of the server are the partition of that reply */
+        tmp = s->list;
+        s->list = s->spare;
+        s->spare = tmp;
+        s->base = s->start[r];
+        s->count = s->start[r + 1] - s->start[r];
+        if(s->count == 0) {
+            return NULL;
+        }
+        choose_guess(s);
+        return &s->current;
+    }
+    for(int i=0; i<s->pins; i++) {
+        guess_colors[s->current.pattern[i]]++;
+    }
+    for(uint32_t w=s->first; w<s->words; w++) {
+        uint64_t word = s->bits[w];
+        uint64_t keep = word;
+        uint32_t prev;
+        int pattern[MAX_PINS];
+
+        if(word == 0) {
+            continue;
+        }
+        COUNT_SCORED(s, __builtin_popcountll(word));
+        /* decode the first candidate of the word, step to the others */
+        prev = w * 64 + __builtin_ctzll(word);
+        decode(s, prev, pattern);
+        while(word != 0) {
+            int b = __builtin_ctzll(word);
+            advance(s, pattern, w * 64 + b - prev);
+            prev = w * 64 + b;
+            if(!consistent(s, guess_colors, pattern, red, white)) {
+                keep &= ~(UINT64_C(1) << b);
+            }
+            word &= word - 1;
+        }
+        s->bits[w] = keep;
+        if(keep != 0) {
+            count += __builtin_popcountll(keep);
+            if(first == s->words) {
+                first = w;
+            }
+        }
+    }
+    s->first = first;
+    s->count = count;
+    if(count == 0) {
+        return NULL;
+    }
+    if(count <= LIST_LIMIT && list_candidates(s) == 0) {
+        choose_guess(s);
+        return &s->current;
     }
-    free(current_guess);
+    decode(s, first * 64 + __builtin_ctzll(s->bits[first]), s->current.pattern);
+    return &s->current;
 }
@@ -7,19 +7,41 @@
 #ifndef STRATEGY_H
 #define STRATEGY_H
 
-typedef struct {
-    int pattern[5];
-} guess;
-
-
+#include <stdio.h>
 
+/*Largest number of pins a solver supports*/
+#define MAX_PINS (8)
 
-guess *init_strat(int *start_guess);
-void play_against(guess *a, guess *b, int *res);
-guess *next_guess(int red, int white);
-void eliminate(int red, int white);
-void fill(int idx, int c1, int c2, int c3, int c4, int c5);
-void free_all();
+typedef struct {
+    int pattern[MAX_PINS];
+} guess;
 
+//State of one game; any number of solvers can be used at the same time
+typedef struct solver solver;
+
+//How a solver chooses among the candidates left
+enum solver_strategy {
+    STRATEGY_FIRST,     //the first candidate
+    STRATEGY_MINIMAX,   //the candidate leaving the fewest candidates in the worst case
+    STRATEGY_ENTROPY    //the candidate whose reply is expected to tell the most
+};
+
+solver *solver_new(const int *start_guess);
+solver *solver_new_variant(int pins, int colors, const int *start_guess);
+void solver_set_strategy(solver *s, enum solver_strategy strategy);
+int parse_strategy(const char *name, enum solver_strategy *strategy);
+int load_opening(const char *path, int pins, int colors, int *pattern);
+const guess *solver_guess(const solver *s);
+const guess *solver_next(solver *s, int red, int white);
+long solver_candidates(const solver *s);
+void solver_free(solver *s);
+
+#ifdef STRATEGY_STATS
+void solver_stats_dump(FILE *out);
+int solver_stats_signal(void);
+#else
+#define solver_stats_dump(out) ((void)0)
+#define solver_stats_signal() (0)
 #endif
 
+#endif
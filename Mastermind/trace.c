@@ -0,0 +1,171 @@
+/** Mastermind Game Trace
+* @file: trace.c
+* @author Michael Reitgruber
+* @date 18.10.2026
+* @brief Background writer of the binary game trace
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "trace.h"
+
+/*Time the writer sleeps when all rings are empty*/
+#define IDLE_NS (1000000L)
+
+volatile sig_atomic_t trace_enabled = 0;
+
+//the trace file and the writer draining into it
+static FILE *trace_file = NULL;
+static struct trace_ring **trace_rings = NULL;
+static int trace_count = 0;
+static pthread_t writer;
+static int stopping = 0;
+static int failed = 0; //writing failed, records are discarded from then on
+
+/**
+ * @brief Writes the records of a ring to the trace file
+ * @param r The ring
+ * @return Number of records written
+ */
+static uint32_t drain(struct trace_ring *r);
+
+/**
+ * @brief Disables tracing after the trace file could not be written, reporting it once
+ */
+static void write_failed(void);
+
+/**
+ * @brief The writer thread
+ * @param arg Unused
+ * @return NULL
+ */
+static void *run_writer(void *arg);
+
+int trace_ring_init(struct trace_ring *r)
+{
+    (void) memset(r, 0, sizeof *r);
+    r->records = malloc(TRACE_RING_SIZE * sizeof *r->records);
+    return r->records == NULL ? -1 : 0;
+}
+
+void trace_ring_free(struct trace_ring *r)
+{
+    free(r->records);
+    r->records = NULL;
+}
+
+int trace_start(const char *path, struct trace_ring **rings, int count, int slots, int colors)
+{
+    struct trace_header header;
+
+    trace_file = fopen(path, "wb");
+    if(trace_file == NULL) {
+        return -1;
+    }
+    (void) memset(&header, 0, sizeof header);
+    (void) memcpy(header.magic, TRACE_MAGIC, sizeof header.magic);
+    header.record_size = sizeof(struct trace_record);
+    header.slots = slots;
+    header.colors = colors;
+    if(fwrite(&header, sizeof header, 1, trace_file) != 1) {
+        (void) fclose(trace_file);
+        trace_file = NULL;
+        return -1;
+    }
+
+    trace_rings = malloc(count * sizeof *trace_rings);
+    if(trace_rings == NULL) {
+        (void) fclose(trace_file);
+        trace_file = NULL;
+        return -1;
+    }
+    (void) memcpy(trace_rings, rings, count * sizeof *trace_rings);
+    trace_count = count;
+    stopping = 0;
+    failed = 0;
+    if((errno = pthread_create(&writer, NULL, run_writer, NULL)) != 0) {
+        free(trace_rings);
+        trace_rings = NULL;
+        (void) fclose(trace_file);
+        trace_file = NULL;
+        return -1;
+    }
+    trace_enabled = 1;
+    return 0;
+}
+
+void trace_stop(void)
+{
+    if(trace_file == NULL) {
+        return;
+    }
+    trace_enabled = 0;
+    __atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+    (void) pthread_join(writer, NULL);
+    if(fclose(trace_file) != 0) {
+        write_failed();
+    }
+    trace_file = NULL;
+    free(trace_rings);
+    trace_rings = NULL;
+}
+
+static uint32_t drain(struct trace_ring *r)
+{
+    uint32_t tail = r->tail;
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    uint32_t count = head - tail;
+
+    while(tail != head) {
+        uint32_t start = tail & (TRACE_RING_SIZE - 1);
+        uint32_t n = head - tail;
+        if(n > TRACE_RING_SIZE - start) {
+            n = TRACE_RING_SIZE - start;
+        }
+        if(failed || fwrite(&r->records[start], sizeof r->records[0], n, trace_file) != n) {
+            write_failed();
+        }
+        tail += n;
+    }
+    __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+    return count;
+}
+
+static void *run_writer(void *arg)
+{
+    const struct timespec idle = {0, IDLE_NS};
+
+    for(;;) {
+        /* once stopping is seen, one more pass catches everything */
+        int stop = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+        uint32_t written = 0;
+
+        for(int i=0; i<trace_count; i++) {
+            written += drain(trace_rings[i]);
+        }
+        if(written == 0) {
+            if(stop) {
+                break;
+            }
+            if(!failed && fflush(trace_file) != 0) {
+                write_failed();
+            }
+            (void) nanosleep(&idle, NULL);
+        }
+    }
+    return NULL;
+}
+
+static void write_failed(void)
+{
+    /* a truncated trace would be decoded as if complete, so the file is not written any further */
+    trace_enabled = 0;
+    if(!failed) {
+        failed = 1;
+        (void) fprintf(stderr, "Error writing trace file, tracing disabled: %s\n", strerror(errno));
+    }
+}
@@ -0,0 +1,106 @@
+/** Mastermind Game Trace
+* @file: trace.h
+* @author Michael Reitgruber
+* @date 18.10.2026
+* @brief Binary per-round trace of the Mastermind server
+* @details Every worker appends fixed-size records to its own single-producer ring buffer; a background thread drains
+*          the rings into the trace file. A full ring drops records instead of stalling the worker. The file starts
+*          with a struct trace_header followed by records in host byte order; tracedump prints it.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <signal.h>
+
+#define TRACE_MAGIC "MMTRACE2"
+
+/*Number of records per ring, a power of two*/
+#define TRACE_RING_SIZE (1 << 16)
+
+//Start of a trace file
+struct trace_header {
+    char magic[8];
+    uint32_t record_size;
+    uint8_t slots;          //number of pins and colors of the games
+    uint8_t colors;
+    uint8_t reserved[2];
+};
+
+//One played round
+struct trace_record {
+    uint64_t ns;            //CLOCK_REALTIME when the reply was computed
+    uint32_t conn;          //connection number, unique per worker
+    uint32_t game;          //game id of a framed connection, 0 on a classic one
+    uint32_t request;
+    uint16_t worker;
+    uint16_t reply;
+    uint8_t round;
+    uint8_t reserved[7];
+};
+
+//Ring written by one worker and read by the trace writer
+struct trace_ring {
+    struct trace_record *records;
+    uint32_t head;          //next record to write, owned by the worker
+    uint32_t tail_cache;    //last tail seen by the worker
+    unsigned long dropped;  //records lost to a full ring
+    char pad[64];           //keep the writer's tail off the worker's cache line
+    uint32_t tail;          //next record to read, owned by the writer
+};
+
+//Whether records are produced; toggled at runtime
+extern volatile sig_atomic_t trace_enabled;
+
+/**
+ * @brief Creates the trace file and starts the writer thread
+ * @param path The trace file
+ * @param rings The rings to drain, one per worker; the array is copied
+ * @param count Number of rings
+ * @param slots Number of pins of the games, recorded in the header
+ * @param colors Number of colors of the games, recorded in the header
+ * @return 0 on success, -1 on error with errno set
+ */
+int trace_start(const char *path, struct trace_ring **rings, int count, int slots, int colors);
+
+/**
+ * @brief Drains the rings, stops the writer thread and closes the trace file
+ * @detail The workers must not produce any more records
+ */
+void trace_stop(void);
+
+/**
+ * @brief Allocates the records of a ring
+ * @param r The ring
+ * @return 0 on success, -1 on error
+ */
+int trace_ring_init(struct trace_ring *r);
+
+/**
+ * @brief Frees the records of a ring
+ * @param r The ring
+ */
+void trace_ring_free(struct trace_ring *r);
+
+/**
+ * @brief Appends a record to a ring, dropping it if the ring is full
+ * @param r The ring
+ * @param rec The record
+ */
+static inline void trace_push(struct trace_ring *r, const struct trace_record *rec)
+{
+    uint32_t head = r->head;
+
+    if(head - r->tail_cache >= TRACE_RING_SIZE) {
+        r->tail_cache = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if(head - r->tail_cache >= TRACE_RING_SIZE) {
+            r->dropped++;
+            return;
+        }
+    }
+    r->records[head & (TRACE_RING_SIZE - 1)] = *rec;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,101 @@
+/** Mastermind Trace Decoder
+* @file: tracedump.c
+* @author Michael Reitgruber
+* @date 18.10.2026
+* @brief Prints a binary game trace written by the Mastermind server
+* @details One line per round: time, worker, connection, game, round, guess, red and white pins and error flags.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include "rules.h"
+#include "trace.h"
+
+//name of the program
+static const char *progname = "tracedump";
+
+//number of pins and colors of the traced games
+static struct variant variant;
+
+/**
+ * @brief Prints one record
+ * @param rec The record
+ */
+static void print_record(const struct trace_record *rec);
+
+/**
+ * @brief Main entry point, decodes the trace file given as argument
+ * @param argc Number of arguments passed to the program
+ * @param argv Array containing the passed arguments
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+int main(int argc, char *argv[])
+{
+    struct trace_header header;
+    struct trace_record rec;
+    FILE *f;
+
+    if(argc > 0) {
+        progname = argv[0];
+    }
+    if(argc != 2) {
+        (void) fprintf(stderr, "Usage: %s <trace-file>\n", progname);
+        return EXIT_FAILURE;
+    }
+    if((f = fopen(argv[1], "rb")) == NULL) {
+        (void) fprintf(stderr, "%s: %s: %s\n", progname, argv[1], strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if(fread(&header, sizeof header, 1, f) != 1
+       || memcmp(header.magic, TRACE_MAGIC, sizeof header.magic) != 0
+       || header.record_size != sizeof rec
+       || variant_init(&variant, header.slots, header.colors) == -1) {
+        (void) fprintf(stderr, "%s: %s: not a trace file\n", progname, argv[1]);
+        (void) fclose(f);
+        return EXIT_FAILURE;
+    }
+
+    (void) printf("%-20s %6s %10s %10s %5s %-9s %3s %5s %s\n",
+                  "time", "worker", "conn", "game", "round", "guess", "red", "white", "flags");
+    while(fread(&rec, sizeof rec, 1, f) == 1) {
+        print_record(&rec);
+    }
+    (void) fclose(f);
+    return EXIT_SUCCESS;
+}
+
+static void print_record(const struct trace_record *rec)
+{
+    /* the server's color letters, or hex digits if there are more colors */
+    const char *colors = variant.colors <= COLORS ? "bdgorsvw" : "0123456789abcdef";
+    char guess[MAX_SLOTS + 1];
+    int red, white, parity, lost;
+
+    if(variant.wide) {
+        uint32_t index = rec->request & ~(1u << WIDE_PARITY_SHIFT);
+        for(int i=0; i<variant.slots; i++, index/=variant.colors) {
+            guess[i] = colors[index % variant.colors];
+        }
+        red = rec->reply & 0xf;
+        white = (rec->reply >> WIDE_WHITE_SHIFT) & 0xf;
+        parity = rec->reply & (1 << WIDE_PARITY_ERR_BIT);
+        lost = rec->reply & (1 << WIDE_GAME_LOST_ERR_BIT);
+    } else {
+        for(int i=0; i<SLOTS; i++) {
+            guess[i] = colors[(rec->request >> (SHIFT_WIDTH * i)) & 0x7];
+        }
+        red = rec->reply & 0x7;
+        white = (rec->reply >> SHIFT_WIDTH) & 0x7;
+        parity = rec->reply & (1 << PARITY_ERR_BIT);
+        lost = rec->reply & (1 << GAME_LOST_ERR_BIT);
+    }
+    guess[variant.slots] = '\0';
+    (void) printf("%10llu.%09llu %6u %10u %10u %5u %-9s %3d %5d %s%s\n",
+                  (unsigned long long)(rec->ns / 1000000000u),
+                  (unsigned long long)(rec->ns % 1000000000u),
+                  rec->worker, rec->conn, rec->game, rec->round, guess,
+                  red, white, parity ? "parity " : "", lost ? "lost" : "");
+}
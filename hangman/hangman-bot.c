@@ -0,0 +1,510 @@
+/** hangman-bot
+  * @author Michael Reitgruber, 1426100
+  * @brief Plays hangman against the server without a human, using a dictionary
+  * @detail Keeps the words of the dictionary that fit everything the server has shown: the length, the revealed
+  *         positions and the missed letters. The words are indexed by length, and loading records for every word
+  *         the positions of each of its characters as a bitmap, so a response filters the words left by comparing
+  *         masks only, without looking at the words again. Letters that every candidate contains cannot miss, so they are
+  *         played together in one PLAY_BATCH; otherwise the bot plays the letter that splits the candidates best,
+  *         the one contained in closest to half of them, so a hit or a miss rules out as many words as possible
+  *         either way. Once no candidate is left it plays in common letter order.
+  *         Plays until the server runs out of words, and prints the games and the round trips per second.
+  * @date 18.10.2026
+  **/
+
+#include "hangman-common.h"
+#include "hangman-conn.h"
+#include "hangman-dict.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+/*Letters in the order of their frequency in English, played once no candidate is left*/
+#define LETTER_ORDER "ETAOINSHRDLCUMWFGYPBVKJXQZ"
+
+/*Bit of a character in the character masks, spaces after the letters*/
+#define SPACE_BIT (1u << 26)
+#define CHAR_BIT_OF(c) ((c) == ' ' ? SPACE_BIT : (c) >= 'A' && (c) <= 'Z' ? 1u << ((c) - 'A') : 0u)
+
+static const char *progname = "hangman-bot"; //name of the program
+static struct conn conn; //connection to the server
+static struct comm *shared; //request and response in the mailbox
+
+static struct dict dict; //the dictionary
+static uint32_t *by_length = NULL; //indices of the words, ordered by length
+static uint32_t first[WORD_LENGTH + 1]; //words of length l are by_length[first[l]] to by_length[first[l + 1] - 1]
+static int spaces[WORD_LENGTH]; //whether a word of the length contains a space
+static uint32_t *chars = NULL; //characters of every word, bit i for 'A' + i and SPACE_BIT
+static uint32_t *first_position = NULL; //index of the first position bitmap of every word
+static uint64_t *positions = NULL; //bit i set if character i of the word is the character, one per bit of chars[]
+static uint32_t *candidates = NULL; //the words still fitting the game
+static uint32_t candidate_count = 0;
+
+static long round_trips = 0; //requests answered by the server
+
+static volatile sig_atomic_t want_quit = 0;
+
+/**
+  * Credit to the OSUE-Team
+  * @brief terminate program on program error
+  * @param exitcode exit code
+  * @param fmt format string
+  */
+static void bail_out(int exitcode, const char *fmt, ...);
+
+/**
+  * @brief prints correct usage of the program to stderr and exits
+  */
+static void usage(void);
+
+/**
+  * @brief free allocated resources
+  */
+static void free_resources(void);
+
+/**
+  * @brief allocate necessary resources
+  */
+static void allocate_resources(void);
+
+/**
+  * @brief orders the words of the dictionary by length and records the positions of their characters
+  */
+static void index_words(void);
+
+/**
+  * @brief returns where a character is in a word
+  * @param index the index of the word
+  * @param bit the bit of the character, CHAR_BIT_OF
+  * @return bit i set if character i of the word is the character
+  */
+static uint64_t positions_of(uint32_t index, uint32_t bit);
+
+/**
+  * @brief connects to the server, exits if that fails or the bot is stopped first
+  */
+static void connect_server(void);
+
+/**
+  * @brief sends the request in the mailbox and waits for the response, exits if the server terminated
+  * @param rtype the kind of request
+  */
+static void request(int rtype);
+
+/**
+  * @brief plays the game started by the last NEW
+  * @return WON or LOST
+  */
+static int play_game(void);
+
+/**
+  * @brief makes the words of the length of the new game the candidates
+  */
+static void start_candidates(void);
+
+/**
+  * @brief keeps the candidates having a character exactly at the revealed positions of it
+  * @param letter the character
+  */
+static void keep_positions(char letter);
+
+/**
+  * @brief keeps the candidates not containing a missed letter
+  * @param letter the missed letter
+  */
+static void drop_letter(char letter);
+
+/**
+  * @brief chooses the letters to play next
+  * @param letters receives the letters
+  * @return the number of letters
+  */
+static int choose(char *letters);
+
+/**
+  * @brief measures how unevenly a letter splits the candidates
+  * @param count the number of candidates containing the letter
+  * @return the distance of twice the count from the number of candidates, 0 for an even split
+  */
+static uint32_t split(uint32_t count);
+
+/**
+  * @brief Signal handler, lets the bot stop after the current game on SIGINT and SIGTERM
+  * @param signal The signal to handle
+  */
+static void handle_signal(int signal);
+
+/**
+  * @brief Main entry point, loads the dictionary and plays until the server runs out of words
+  * @param argc number of arguments
+  * @param argv list of arguments
+  * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+  */
+int main(int argc, char *argv[])
+{
+    const int signals[] = {SIGINT, SIGTERM};
+    struct sigaction ac;
+    struct timespec start, end;
+    const char *path = NULL;
+    long max_games = -1, games = 0, won = 0;
+    int quiet = 0, opt;
+    char *endptr;
+
+    ac.sa_handler = handle_signal;
+    ac.sa_flags = 0;
+    if(sigfillset(&ac.sa_mask) < 0) {
+        bail_out(EXIT_FAILURE, "sigfillset");
+    }
+    for(int i=0; i<2; i++) {
+        if(sigaction(signals[i], &ac, NULL) < 0) {
+            bail_out(EXIT_FAILURE, "sigaction");
+        }
+    }
+
+    if(argc > 0) {
+        progname = argv[0];
+    }
+    while((opt = getopt(argc, argv, "d:g:q")) != -1) {
+        switch(opt) {
+        case 'd':
+            path = optarg;
+            break;
+        case 'g':
+            errno = 0;
+            max_games = strtol(optarg, &endptr, 10);
+            if(errno != 0 || *endptr != '\0' || max_games < 1) {
+                bail_out(EXIT_FAILURE, "Number of games has to be positive");
+            }
+            break;
+        case 'q':
+            quiet = 1;
+            break;
+        default:
+            usage();
+        }
+    }
+    if(path == NULL || optind != argc) {
+        usage();
+    }
+
+    if(dict_load(&dict, path, WORD_LENGTH - 1) == -1) {
+        bail_out(EXIT_FAILURE, "Error loading %s", path);
+    }
+    index_words();
+
+    if(atexit(free_resources) != 0) {
+        bail_out(EXIT_FAILURE, "Error setting cleanup function on exit");
+    }
+    allocate_resources();
+
+    connect_server();
+    (void) clock_gettime(CLOCK_MONOTONIC, &start);
+    while(!want_quit && games != max_games) {
+        request(NEW);
+        if(shared->rtype == NO_MORE_WORDS) {
+            break;
+        }
+        int result = play_game();
+        games++;
+        won += (result == WON);
+        if(!quiet) {
+            char word[WORD_LENGTH];
+            int i;
+            for(i=0; i<shared->length; i++) {
+                word[i] = (shared->revealed >> i) & 1 ? shared->word[i] : '_';
+            }
+            word[i] = '\0';
+            (void) printf("%s %s, %d mistakes\n", word, result == WON ? "won" : "lost", shared->mistakes);
+        }
+    }
+    (void) clock_gettime(CLOCK_MONOTONIC, &end);
+
+    conn_disconnect(&conn);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    (void) printf("%ld games, %ld won, %ld lost, %ld round trips in %.3f s", games, won, games - won,
+                  round_trips, seconds);
+    if(seconds > 0) {
+        (void) printf(", %.0f games/s, %.0f round trips/s", games / seconds, round_trips / seconds);
+    }
+    (void) printf("\n");
+    return EXIT_SUCCESS;
+}
+
+static int play_game(void)
+{
+    char letters[MAX_BATCH];
+    int mistakes = shared->mistakes;
+
+    start_candidates();
+    for(;;) {
+        int count = choose(letters);
+        uint32_t hits;
+
+        if(count == 1) {
+            shared->guess = letters[0];
+            request(PLAY);
+            /* a miss only adds a mistake */
+            hits = shared->mistakes == mistakes;
+        } else {
+            (void) memcpy(shared->guesses, letters, count);
+            shared->batch = count;
+            request(PLAY_BATCH);
+            hits = shared->hits;
+        }
+        mistakes = shared->mistakes;
+        if(shared->rtype == WON || shared->rtype == LOST) {
+            return shared->rtype;
+        }
+
+        for(int k=0; k<count; k++) {
+            if((hits >> k) & 1) {
+                keep_positions(letters[k]);
+            } else {
+                drop_letter(letters[k]);
+            }
+        }
+    }
+}
+
+static int choose(char *letters)
+{
+    uint32_t counts[26] = {0};
+    uint32_t guessed = shared->guessed;
+    int count = 0, best = -1;
+
+    for(uint32_t k=0; k<candidate_count; k++) {
+        uint32_t m = dict.meta[candidates[k]].mask & ~guessed;
+        while(m != 0) {
+            counts[__builtin_ctz(m)]++;
+            m &= m - 1;
+        }
+    }
+    for(int i=0; i<26; i++) {
+        if(candidate_count > 0 && counts[i] == candidate_count && count < MAX_BATCH) {
+            letters[count++] = 'A' + i; //in every candidate, cannot miss
+        }
+        /* closest to half the candidates; of two equally close, the one less likely to miss */
+        if(counts[i] > 0 && (best == -1 || split(counts[i]) < split(counts[best])
+                             || (split(counts[i]) == split(counts[best]) && counts[i] > counts[best]))) {
+            best = i;
+        }
+    }
+    if(count > 0) {
+        return count;
+    }
+    if(best != -1) {
+        letters[0] = 'A' + best;
+        return 1;
+    }
+    for(const char *l=LETTER_ORDER; *l != '\0'; l++) {
+        if((guessed & (1u << (*l - 'A'))) == 0) {
+            letters[0] = *l;
+            return 1;
+        }
+    }
+    bail_out(EXIT_FAILURE, "No letter left to play");
+    return 0;
+}
+
+static uint32_t split(uint32_t count)
+{
+    return 2 * count > candidate_count ? 2 * count - candidate_count : candidate_count - 2 * count;
+}
+
+static void start_candidates(void)
+{
+    int length = shared->length;
+
+    candidate_count = 0;
+    if(length < 1 || length >= WORD_LENGTH) {
+        return;
+    }
+    candidate_count = first[length + 1] - first[length];
+    (void) memcpy(candidates, by_length + first[length], candidate_count * sizeof *candidates);
+    if(spaces[length]) {
+        keep_positions(' ');
+    }
+}
+
+static void keep_positions(char letter)
+{
+    uint64_t want = 0;
+    uint32_t bit = CHAR_BIT_OF(letter);
+    uint32_t kept = 0;
+
+    for(int i=0; i<shared->length; i++) {
+        if((shared->revealed >> i) & 1 && shared->word[i] == letter) {
+            want |= (uint64_t)1 << i;
+        }
+    }
+    for(uint32_t k=0; k<candidate_count; k++) {
+        if(positions_of(candidates[k], bit) == want) {
+            candidates[kept++] = candidates[k];
+        }
+    }
+    candidate_count = kept;
+}
+
+static uint64_t positions_of(uint32_t index, uint32_t bit)
+{
+    /* the bitmaps of a word follow the order of the bits of its characters */
+    if((chars[index] & bit) == 0) {
+        return 0;
+    }
+    return positions[first_position[index] + __builtin_popcount(chars[index] & (bit - 1))];
+}
+
+static void drop_letter(char letter)
+{
+    uint32_t bit = 1u << (letter - 'A');
+    uint32_t kept = 0;
+
+    for(uint32_t k=0; k<candidate_count; k++) {
+        if((dict.meta[candidates[k]].mask & bit) == 0) {
+            candidates[kept++] = candidates[k];
+        }
+    }
+    candidate_count = kept;
+}
+
+static void index_words(void)
+{
+    uint32_t fill[WORD_LENGTH + 1];
+    uint64_t total = 0;
+    uint32_t n = dict.words > 0 ? dict.words : 1;
+
+    by_length = malloc(n * sizeof *by_length);
+    candidates = malloc(n * sizeof *candidates);
+    chars = malloc(n * sizeof *chars);
+    first_position = malloc(n * sizeof *first_position);
+    if(by_length == NULL || candidates == NULL || chars == NULL || first_position == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating word index");
+    }
+
+    /* counting sort, first[l] counts the words shorter than l */
+    (void) memset(first, 0, sizeof first);
+    for(uint32_t i=0; i<dict.words; i++) {
+        int length = dict.meta[i].length;
+
+        chars[i] = dict.meta[i].mask;
+        if(length < WORD_LENGTH) {
+            first[length + 1]++;
+            if(strchr(dict_word(&dict, i), ' ') != NULL) {
+                chars[i] |= SPACE_BIT;
+                spaces[length] = 1;
+            }
+        }
+        first_position[i] = total;
+        total += __builtin_popcount(chars[i]);
+        if(total > UINT32_MAX) {
+            errno = 0;
+            bail_out(EXIT_FAILURE, "Dictionary too large to index");
+        }
+    }
+    for(int l=1; l<=WORD_LENGTH; l++) {
+        first[l] += first[l - 1];
+    }
+    (void) memcpy(fill, first, sizeof fill);
+
+    if((positions = calloc(total > 0 ? total : 1, sizeof *positions)) == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating word index");
+    }
+    for(uint32_t i=0; i<dict.words; i++) {
+        const char *w = dict_word(&dict, i);
+        int length = dict.meta[i].length;
+
+        if(length < WORD_LENGTH) {
+            by_length[fill[length]++] = i;
+        }
+        for(int k=0; w[k] != '\0' && k<length; k++) {
+            uint32_t bit = CHAR_BIT_OF(w[k]);
+            if(chars[i] & bit) {
+                positions[first_position[i] + __builtin_popcount(chars[i] & (bit - 1))] |= (uint64_t)1 << k;
+            }
+        }
+    }
+}
+
+static void connect_server(void)
+{
+    switch(conn_connect(&conn, &want_quit)) {
+    case CONN_OK:
+        shared = conn.comm;
+        return;
+    case CONN_QUIT:
+        exit(EXIT_SUCCESS);
+    case CONN_FULL:
+        (void) fprintf(stderr, "Server has no free slot, try again later\n");
+        exit(EXIT_FAILURE);
+    case CONN_TERMINATED:
+        (void) fprintf(stderr, "\nServer terminated unexpectedly\n");
+        exit(EXIT_SUCCESS);
+    default:
+        bail_out(EXIT_FAILURE, "Error connecting to server");
+    }
+}
+
+static void request(int rtype)
+{
+    if(conn_request(&conn, rtype) == CONN_TERMINATED) {
+        (void) fprintf(stderr, "\nServer terminated unexpectedly\n");
+        exit(EXIT_SUCCESS);
+    }
+    round_trips++;
+}
+
+static void usage(void)
+{
+    (void) fprintf(stderr, "Usage: %s -d <dictionary> [-g <games>] [-q]\n", progname);
+    exit(EXIT_FAILURE);
+}
+
+static void bail_out(int exitcode, const char *fmt, ...) {
+    va_list ap;
+    (void) fprintf(stderr, "%s: ", progname);
+    if(fmt != NULL) {
+        va_start(ap, fmt);
+        (void) vfprintf(stderr, fmt, ap);
+        va_end(ap);
+    }
+    if(errno != 0) {
+        (void) fprintf(stderr, ": %s", strerror(errno));
+    }
+    (void)fprintf(stderr, "\n");
+
+    exit(exitcode);
+}
+
+static void free_resources() {
+    if(conn_close(&conn) == -1) {
+        (void) fprintf(stderr, "Error unmapping shared memory");
+    }
+    free(by_length);
+    free(candidates);
+    free(chars);
+    free(first_position);
+    free(positions);
+    dict_free(&dict);
+}
+
+static void allocate_resources()
+{
+    if(conn_open(&conn) == CONN_ERROR) {
+        if(errno == ENOENT) {
+            (void) fprintf(stderr, "Server not running\n");
+            exit(EXIT_FAILURE);
+        }
+        bail_out(EXIT_FAILURE, "Error accessing shared memory");
+    }
+}
+
+static void handle_signal(int signal)
+{
+    want_quit = 1;
+}
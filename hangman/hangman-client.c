@@ -2,31 +2,25 @@
   * @author Michael Reitgruber, 1426100
   * @brief Implements a client for the game hangman
   * @detail Communicates to the server via Linux shared memory,  allows to play until the server runs out of words
+  *         After CONNECT all requests go through the client's own mailbox slot, see hangman-conn.h
   * @date 08.12.2015
   **/
 
 
 #include "hangman-common.h"
+#include "hangman-conn.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <sys/mman.h>
-#include <sys/types.h>
-#include <fcntl.h>
-#include <unistd.h>
 #include <stdarg.h>
-#include <semaphore.h>
 #include <ctype.h>
 #include <string.h>
 #include <signal.h>
 #include <assert.h>
 
-static int shmfd = -1;
 static const char *progname = "./hangman-client"; //name of the program
-static struct comm *shared; //pointer to shared memory
-static sem_t *sem_serv;
-static sem_t *sem_client;
-static sem_t *sem_comm;
+static struct conn conn; //connection to the server
+static struct comm *shared; //request and response in the mailbox
 
 
 static volatile sig_atomic_t want_quit = 0;
@@ -50,16 +44,15 @@ static void free_resources(void);
 static void allocate_resources(void);
 
 /**
-  * @brief waits for semaphore and checks for errors
-  * @param sem the semaphore to wait for
+  * @brief connects to the server, exits if that fails or the user quits first
   */
-static void cwait(sem_t *sem);
+static void connect_server(void);
 
 /**
-  * @brief posts to semaphore and checks for errors
-  * @param sem the semaphore to post to
+  * @brief sends the request in the mailbox and waits for the response, exits if the server terminated
+  * @param rtype the kind of request
   */
-static void cpost(sem_t *sem);
+static void request(int rtype);
 
 /**
   * @brief Signal handler, exits the program gracefully on SIGINT and SIGTERM
@@ -75,11 +68,25 @@ static void handle_signal(int signal);
 static void draw_hangman(int mistakes);
 
 
+/**
+  * @brief reads the letters to play next from stdin, asking again until the input is valid
+  * @detail Several letters on one line are played in order with one PLAY_BATCH request
+  * @param letters receives the letters, uppercase
+  * @param guessed_letters array containing guessed letter information
+  * @return the number of letters, 0 on EOF or if the program should quit
+  */
+static int read_letters(char *letters, char *guessed_letters);
+
+/**
+  * @brief prints the word, the positions not revealed yet as underscores
+  */
+static void print_word(void);
+
 /**
   * @brief prints the list of already guessed letters
-  * @param letters The list of letters
+  * @param letters The letters, bit i for 'A' + i
   */
-static void print_letters(char *letters);
+static void print_letters(uint32_t letters);
 
 /**
   * @brief checks if a character is a valid choice
@@ -127,72 +134,42 @@ int main(int argc, char *argv[])
     allocate_resources();
 
 
-    int cno = 0;
     char guessed_letters[26]={0};
 
     /* Connect to server */
-    cwait(sem_client);
-
-    shared->rtype = CONNECT;
-
-    cpost(sem_serv);
-    cwait(sem_comm);
-
-    cno = shared->cno;
-
-    cpost(sem_serv);
+    connect_server();
 
-    cwait(sem_client);
-
-    shared->cno = cno;
-    shared->rtype = NEW;
-
-    cpost(sem_serv);
-    cwait(sem_comm);
+    request(NEW);
     while(!want_quit) {
-        int c = 0;
-        do {
-            if(c != '\n') {
-               (void)printf("\nEnter next character: ");
-            }
-            c = fgetc(stdin);
-            if(want_quit)
-                break;
-            (void) fflush(stdin);
-            if(c == '\n')
-                continue;
+        char letters[MAX_BATCH];
+        int count = read_letters(letters, guessed_letters);
 
-            int t;
-            while((t = fgetc(stdin)!='\n')); 
-
-            if(valid(c, guessed_letters)) {
-                break;
-            }
-            (void) printf("\nInvalid input (only 1 ascii letter per turn or letter already played)\n");
-            (void) fflush(stdout);
-        }while(!want_quit);
-
-        if(want_quit) {
+        if(count == 0) {
             break; 
         }
-        cwait(sem_client);
-        if(errno == EINTR) continue;
 
-        shared->rtype = PLAY;
-        shared->cno = cno;
-    
-        guessed_letters[toupper(c)-'A'] = 1; //mark as already used;
-        shared->guess = (char)c;
-        cpost(sem_serv);
-        
-        cwait(sem_comm);
-        if(errno == EINTR) continue;
+        if(count == 1) {
+            guessed_letters[letters[0]-'A'] = 1; //mark as already used;
+            shared->guess = letters[0];
+            request(PLAY);
+        }
+        else {
+            (void) memcpy(shared->guesses, letters, count);
+            shared->batch = count;
+            request(PLAY_BATCH);
+            (void) printf("\n");
+            for(int i=0; i<shared->batch; i++) {
+                guessed_letters[letters[i]-'A'] = 1;
+                (void) printf("%c %s  ", letters[i], (shared->hits >> i) & 1 ? "hit" : "miss");
+            }
+            (void) printf("\n");
+        }
        
 
         draw_hangman(shared->mistakes);
         (void) printf("\n");
-        (void) printf("%s\n", shared->word); 
-        print_letters(shared->guessed_letters);
+        print_word();
+        print_letters(shared->guessed);
 
         if(shared->rtype == WON || shared->rtype == LOST) {
             if(shared->rtype == WON) {
@@ -206,17 +183,11 @@ int main(int argc, char *argv[])
             char c = (char)fgetc(stdin);
             (void)fgetc(stdin); //get rid of line feed
             if(tolower(c) == 'y') {
-                cwait(sem_client);
-                if(errno == EINTR) continue;
-                shared->cno = cno;
                 for(int i=0; i<26; i++) {
                     guessed_letters[i]=0;
                 }
        
-                shared->rtype = NEW;
-                cpost(sem_serv);
-                cwait(sem_comm);
-                if(errno == EINTR) continue;
+                request(NEW);
                 if(shared->rtype==NO_MORE_WORDS) {
                     (void)printf("\nNo words left!\n");
                     (void)printf("Final standings: Won %d, Lost %d.\n", shared->wins, shared->losses);
@@ -231,32 +202,35 @@ int main(int argc, char *argv[])
 
     }
 
-    /* Disconnect from server */
-    cwait(sem_client);
-
-    shared->cno = cno;
-    shared->rtype = DISCONNECT;
-    cpost(sem_serv);
+    conn_disconnect(&conn);
 
     return EXIT_SUCCESS;
 }
 
-static void cwait(sem_t *sem) {
-    if(sem_wait(sem) == -1) {
-        if(errno != EINTR) {
-            bail_out(EXIT_FAILURE, "Error waiting on semaphore");
-        }
-    }
-    if(shared->terminate == 1) {
-        cpost(sem_client);
+static void connect_server(void)
+{
+    switch(conn_connect(&conn, &want_quit)) {
+    case CONN_OK:
+        shared = conn.comm;
+        return;
+    case CONN_QUIT:
+        exit(EXIT_SUCCESS);
+    case CONN_FULL:
+        (void) fprintf(stderr, "Server has no free slot, try again later\n");
+        exit(EXIT_FAILURE);
+    case CONN_TERMINATED:
         (void) fprintf(stderr, "\nServer terminated unexpectedly\n");
         exit(EXIT_SUCCESS);
+    default:
+        bail_out(EXIT_FAILURE, "Error connecting to server");
     }
 }
 
-static void cpost(sem_t *sem) {
-    if(sem_post(sem) == -1) {
-        bail_out(EXIT_FAILURE, "Error posting to semaphore");
+static void request(int rtype)
+{
+    if(conn_request(&conn, rtype) == CONN_TERMINATED) {
+        (void) fprintf(stderr, "\nServer terminated unexpectedly\n");
+        exit(EXIT_SUCCESS);
     }
 }
 
@@ -265,7 +239,7 @@ static void bail_out(int exitcode, const char *fmt, ...) {
     (void) fprintf(stderr, "%s: ", progname);
     if(fmt != NULL) {
         va_start(ap, fmt);
-        (void) fprintf(stderr, fmt, ap);
+        (void) vfprintf(stderr, fmt, ap);
         va_end(ap);
     }
     if(errno != 0) {
@@ -277,57 +251,20 @@ static void bail_out(int exitcode, const char *fmt, ...) {
 }
 
 static void free_resources() {
-    if(munmap(shared, sizeof *shared) == -1) {
+    if(conn_close(&conn) == -1) {
         (void) fprintf(stderr, "Error unmapping shared memory");
     }
-    if(sem_close(sem_serv) == -1) {
-        (void) fprintf(stderr, "Error closing semaphore %s\n", SEM_SERV_NAME);
-    }
-    if(sem_close(sem_client) == -1) {
-        (void) fprintf(stderr, "Error closing semaphore %s\n", SEM_CLIENT_NAME);
-    }
-    if(sem_close(sem_comm) == -1) {
-        (void) fprintf(stderr, "Error closing semaphore %s\n", SEM_COMM_NAME);
-    }
 }
 
 static void allocate_resources()
 {
-
-    shmfd = shm_open(SHM_NAME, O_RDWR, 0);
-
-    sem_serv = sem_open(SEM_SERV_NAME, 0);
-    if(sem_serv == SEM_FAILED) {
+    if(conn_open(&conn) == CONN_ERROR) {
         if(errno == ENOENT) {
             (void) fprintf(stderr, "Server not running\n");
             exit(EXIT_FAILURE);
         }
-    }
-    
-    sem_client = sem_open(SEM_CLIENT_NAME, 0);
-    if(sem_client == SEM_FAILED) {
-        bail_out(EXIT_FAILURE, "Error opening semaphore %s", SEM_CLIENT_NAME);
-    }
-
-    sem_comm = sem_open(SEM_COMM_NAME, 0);
-    if(sem_comm == SEM_FAILED) {
-        bail_out(EXIT_FAILURE, "Error opening semaphore %s", SEM_COMM_NAME);
-    }
-
-    if(shmfd == -1) {
         bail_out(EXIT_FAILURE, "Error accessing shared memory");
     }
-
-    shared = mmap(NULL, sizeof *shared, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
-
-    if(shared == MAP_FAILED) {
-        bail_out(EXIT_FAILURE, "Mapping shared memory failed");
-    }
-
-    if(close(shmfd) == -1) {
-        bail_out(EXIT_FAILURE, "Error closing shared memory file descriptor");
-    }
-    
 }
 static void draw_hangman(int mistakes) 
 {
@@ -377,11 +314,66 @@ static void draw_hangman(int mistakes)
     }
 }
 
-static void print_letters(char *letters)
+static int read_letters(char *letters, char *guessed_letters)
+{
+    char line[WORD_LENGTH];
+    int prompt = 1;
+
+    while(!want_quit) {
+        char batch_letters[26];
+        int count = 0, ok = 1, t;
+
+        if(prompt) {
+            (void)printf("\nEnter next character: ");
+            (void) fflush(stdout);
+        }
+        if(fgets(line, sizeof line, stdin) == NULL || want_quit) {
+            return 0;
+        }
+        if(strchr(line, '\n') == NULL) {
+            while((t = fgetc(stdin)) != '\n' && t != EOF); //drop the rest of a long line
+        }
+
+        (void) memcpy(batch_letters, guessed_letters, sizeof batch_letters);
+        for(int i=0; line[i] != '\0' && line[i] != '\n'; i++) {
+            if(count == MAX_BATCH || !valid(line[i], batch_letters)) {
+                ok = 0;
+                break;
+            }
+            letters[count] = (char)toupper(line[i]);
+            batch_letters[letters[count]-'A'] = 1; //each letter once per batch
+            count++;
+        }
+        if(ok && count > 0) {
+            return count;
+        }
+        prompt = !ok;
+        if(!ok) {
+            (void) printf("\nInvalid input (only ascii letters not played yet, each once)\n");
+            (void) fflush(stdout);
+        }
+    }
+    return 0;
+}
+
+static void print_word(void)
+{
+    char word[WORD_LENGTH];
+    uint64_t revealed = shared->revealed;
+    int i;
+
+    for(i=0; i<shared->length && i<WORD_LENGTH-1; i++) {
+        word[i] = (revealed >> i) & 1 ? shared->word[i] : '_';
+    }
+    word[i] = '\0';
+    (void) printf("%s\n", word);
+}
+
+static void print_letters(uint32_t letters)
 {
     (void) printf("Used letters: ");
     for(int i=0; i<26; i++) {
-        if(letters[i] == 1) {
+        if((letters >> i) & 1) {
             (void) printf("%c", 'A'+i); //prints the i-th letter of the alphabet, when it has already been used
         }
     }
@@ -397,7 +389,7 @@ static int contains(char c, char *letters)
 
 static int valid(int c, char *letters) 
 {
-    int u =  toupper(c);
+    int u =  toupper((unsigned char)c);
 
     if(u>='A' && u <= 'Z') {
         if(!contains((char)u, letters)) {
@@ -1,12 +1,18 @@
 #ifndef HANGMAN_COMMON_H
 #define HANGMAN_COMMON_H
 
+#include <stdint.h>
+#include <semaphore.h>
+#include "hangman-queue.h"
+
 #define SHM_NAME "/hangman_1426100"
 #define PERM (0600)
 
-#define SEM_SERV_NAME "/sem_serv"
-#define SEM_CLIENT_NAME "/sem_client"
-#define SEM_COMM_NAME "/sem_comm"
+/*Number of clients which can be connected at the same time*/
+#define MAX_CLIENTS 4096
+
+/*Most worker threads of the server, each with its own request ring*/
+#define MAX_WORKERS 32
 
 #define PLAY 1
 #define CONNECT 2
@@ -15,18 +21,47 @@
 #define LOST 5
 #define WON 6
 #define NO_MORE_WORDS 7
+#define SERVER_FULL 8
+#define PLAY_BATCH 9
 #define WORD_LENGTH 64
 
+/*Most letters of a PLAY_BATCH request*/
+#define MAX_BATCH 26
+
+//Request and response; the client builds the word it shows from revealed and word, so a response only writes the
+//characters that become visible
 struct comm {
     int rtype;  //what kind of request we are dealing with
-    int terminate; //only written by server, read by client
     int cno;
     int wins;
     int losses;
-    char guess;
     int mistakes;
-    char guessed_letters[26];
-    char word[WORD_LENGTH];
+    int length; //characters of the word, set by NEW
+    uint32_t guessed; //letters guessed so far, bit i for 'A' + i
+    uint64_t revealed; //bit i set once word[i] is visible, spaces from NEW on
+    int batch; //letters in guesses of PLAY_BATCH, the response holds the number played before the game ended
+    uint32_t hits; //bit k set in the response to PLAY_BATCH if guesses[k] was in the word
+    char guess;
+    char guesses[MAX_BATCH]; //letters of PLAY_BATCH, played in order
+    char word[WORD_LENGTH]; //a character is only written when it becomes visible
+};
+
+//Mailbox of one connected client
+struct slot {
+    uint32_t bell; //rung by the server when comm holds the response
+    int in_use; //only written by server
+    struct comm comm;
+};
+
+//Layout of the shared memory object, initialized by the server
+struct shm {
+    struct ring rings[MAX_WORKERS]; //one entry for every request, the slot index or CONNECT_SLOT on ring 0
+    int workers; //number of rings in use, a client queues on ring cno % workers
+    int terminate; //only written by server, read by client
+    sem_t connect_lock; //serializes CONNECT requests, process-shared
+    uint32_t connect_bell; //rung by the server when connect holds the response
+    struct comm connect; //the response carries the slot of the client in cno, or rtype SERVER_FULL
+    struct slot slots[MAX_CLIENTS];
 };
 
 
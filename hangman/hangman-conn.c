@@ -0,0 +1,126 @@
+/**hangman-conn
+  @author Michael Reitgruber, 1426100
+  @brief Implements the client side of the hangman protocol
+  @date 18.10.2026
+  **/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include "hangman-conn.h"
+
+/**
+  * @brief queues a request on a ring and waits on a doorbell for the response
+  * @param shm the shared memory
+  * @param ring the ring of the worker serving the client
+  * @param entry the ring entry, a slot index or CONNECT_SLOT
+  * @param bell the doorbell the server rings
+  * @return CONN_OK or CONN_TERMINATED
+  */
+static int round_trip(struct shm *shm, struct ring *ring, int entry, uint32_t *bell);
+
+int conn_open(struct conn *c)
+{
+    int fd = shm_open(SHM_NAME, O_RDWR, 0);
+    void *map;
+
+    c->shm = NULL;
+    c->slot = NULL;
+    if(fd == -1) {
+        return CONN_ERROR;
+    }
+    map = mmap(NULL, sizeof *c->shm, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED) {
+        (void) close(fd);
+        return CONN_ERROR;
+    }
+    c->shm = map;
+    if(close(fd) == -1) {
+        return CONN_ERROR;
+    }
+    return CONN_OK;
+}
+
+int conn_connect(struct conn *c, volatile sig_atomic_t *quit)
+{
+    struct shm *shm = c->shm;
+    int ret, index;
+
+    /* the handlers do not restart sem_wait, and going on without the lock would let a second client in */
+    while(sem_wait(&shm->connect_lock) == -1) {
+        if(errno != EINTR) {
+            return CONN_ERROR;
+        }
+        if(*quit) {
+            return CONN_QUIT;
+        }
+    }
+    if(*quit) {
+        ret = CONN_QUIT;
+    } else if(shm->terminate == 1) {
+        ret = CONN_TERMINATED;
+    } else {
+        shm->connect.rtype = CONNECT;
+        ret = round_trip(shm, &shm->rings[0], CONNECT_SLOT, &shm->connect_bell);
+        if(ret == CONN_OK && shm->connect.rtype == SERVER_FULL) {
+            ret = CONN_FULL;
+        }
+    }
+    index = shm->connect.cno;
+    if(sem_post(&shm->connect_lock) == -1) {
+        return CONN_ERROR;
+    }
+    if(ret != CONN_OK) {
+        return ret;
+    }
+    if(index < 0 || index >= MAX_CLIENTS) {
+        errno = EPROTO;
+        return CONN_ERROR;
+    }
+
+    c->slot_index = index;
+    c->slot = &shm->slots[index];
+    c->comm = &c->slot->comm;
+    c->cno = c->comm->cno;
+    return CONN_OK;
+}
+
+int conn_request(struct conn *c, int rtype)
+{
+    c->comm->cno = c->cno;
+    c->comm->rtype = rtype;
+    return round_trip(c->shm, &c->shm->rings[c->cno % c->shm->workers], c->slot_index, &c->slot->bell);
+}
+
+void conn_disconnect(struct conn *c)
+{
+    c->comm->cno = c->cno;
+    c->comm->rtype = DISCONNECT;
+    ring_push(&c->shm->rings[c->cno % c->shm->workers], c->slot_index);
+    c->slot = NULL;
+}
+
+int conn_close(struct conn *c)
+{
+    int ret = 0;
+
+    if(c->shm != NULL) {
+        ret = munmap(c->shm, sizeof *c->shm);
+        c->shm = NULL;
+    }
+    return ret;
+}
+
+static int round_trip(struct shm *shm, struct ring *ring, int entry, uint32_t *bell)
+{
+    bell_reset(bell);
+    ring_push(ring, entry);
+    /* the server sets terminate before it rings the doorbells for the last time, so either the bell rings or this
+       sees terminate; the server answers every request, so a signal does not abandon the response */
+    if(__atomic_load_n(&shm->terminate, __ATOMIC_SEQ_CST) == 0) {
+        bell_wait(bell);
+    }
+    return shm->terminate == 1 ? CONN_TERMINATED : CONN_OK;
+}
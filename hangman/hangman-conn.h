@@ -0,0 +1,69 @@
+/**hangman-conn
+  @author Michael Reitgruber, 1426100
+  @brief Client side of the hangman protocol, shared by hangman-client and hangman-bot
+  @detail CONNECT goes through the connect mailbox, serialized by the connect lock, and hands out a mailbox slot;
+          every later request is written to that slot, queued on the ring of the worker owning the client and
+          answered on the slot's doorbell.
+  @date 18.10.2026
+  **/
+
+#ifndef HANGMAN_CONN_H
+#define HANGMAN_CONN_H
+
+#include <signal.h>
+#include "hangman-common.h"
+
+/*Results of the connection functions*/
+#define CONN_OK 0
+#define CONN_ERROR (-1) //errno is set
+#define CONN_QUIT (-2) //the quit flag was set before CONNECT was sent
+#define CONN_FULL (-3) //the server has no free slot
+#define CONN_TERMINATED (-4) //the server terminated
+
+//Connection of a client to the server
+struct conn {
+    struct shm *shm; //the shared memory, NULL until opened
+    struct slot *slot; //mailbox of the client
+    int slot_index; //index of the mailbox, queued on the request ring
+    int cno; //client number
+    struct comm *comm; //request and response in the mailbox
+};
+
+/**
+  * @brief maps the shared memory of the server
+  * @param c the connection
+  * @return CONN_OK, or CONN_ERROR with errno ENOENT if the server is not running
+  */
+int conn_open(struct conn *c);
+
+/**
+  * @brief asks the server for a mailbox slot and a client number
+  * @detail Waiting for the connect lock is only given up when quit is set, never without holding the lock
+  * @param c the opened connection
+  * @param quit set by the signal handlers of the program
+  * @return CONN_OK, CONN_QUIT, CONN_FULL, CONN_TERMINATED or CONN_ERROR
+  */
+int conn_connect(struct conn *c, volatile sig_atomic_t *quit);
+
+/**
+  * @brief sends the request in the mailbox and waits for the response, a signal does not abandon it
+  * @param c the connected connection
+  * @param rtype the kind of request
+  * @return CONN_OK or CONN_TERMINATED
+  */
+int conn_request(struct conn *c, int rtype);
+
+/**
+  * @brief disconnects from the server without waiting, the slot is free again once the server handled it
+  * @param c the connected connection
+  */
+void conn_disconnect(struct conn *c);
+
+/**
+  * @brief unmaps the shared memory
+  * @param c the connection, may be unopened
+  * @return 0 on success, -1 on error
+  */
+int conn_close(struct conn *c);
+
+#endif
@@ -0,0 +1,203 @@
+/**hangman-dict
+  @author Michael Reitgruber, 1426100
+  @brief Implements loading the word lists of the hangman server
+  @detail A text list is filtered in one pass into a single arena of NUL-terminated words, indexed by their offsets;
+          the file is mapped instead of read. A compiled dictionary is only checked for a consistent header, so
+          loading it takes the same time whatever its size; the word bytes end with a NUL, so no word runs past them.
+  @date 18.10.2026
+  **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "hangman-dict.h"
+
+/**
+  * @brief appends a word to the tables, doubling them when full
+  * @param offsets the offset table
+  * @param meta the metadata table
+  * @param words number of words in the tables, incremented
+  * @param capacity number of entries allocated, updated
+  * @param offset the offset of the word
+  * @param word the word
+  * @param length the number of characters of the word
+  * @return 0 on success, -1 on error
+  */
+static int append(uint32_t **offsets, struct dict_meta **meta, uint32_t *words, uint32_t *capacity,
+                  uint32_t offset, const char *word, int length);
+
+/**
+  * @brief checks that a compiled dictionary is complete and fits the server
+  * @param h the header
+  * @param size the size of the file
+  * @param max_length the most characters of a word
+  * @return 0 if usable, -1 else
+  */
+static int check(const struct dict_header *h, size_t size, int max_length);
+
+int dict_filter(struct dict *d, const char *text, size_t size, int max_length)
+{
+    uint32_t *offsets = NULL, words = 0, capacity = 0;
+    struct dict_meta *meta = NULL;
+    size_t pos = 0, start = 0;
+    char *arena;
+    int length = 0;
+
+    if(size >= UINT32_MAX) {
+        errno = EFBIG;
+        return -1;
+    }
+    /* a word is never longer than its line, and its NUL takes the place of the line feed */
+    if((arena = malloc(size + 1)) == NULL) {
+        return -1;
+    }
+    for(size_t i=0; i<=size; i++) {
+        if(i == size || text[i] == '\n') {
+            if(length > 0) {
+                arena[pos++] = '\0';
+                if(append(&offsets, &meta, &words, &capacity, start, arena + start, length) == -1) {
+                    free(arena);
+                    free(offsets);
+                    free(meta);
+                    return -1;
+                }
+            }
+            start = pos;
+            length = 0;
+            continue;
+        }
+        char u = (char)toupper((unsigned char)text[i]);
+        if(((u >= 'A' && u <= 'Z') || u == ' ') && length < max_length) {
+            arena[pos++] = u;
+            length++;
+        }
+    }
+
+    /* give back what the filter dropped */
+    char *tmp = realloc(arena, pos > 0 ? pos : 1);
+    if(tmp != NULL) {
+        arena = tmp;
+    }
+    d->bytes = arena;
+    d->bytes_size = pos;
+    d->offsets = offsets;
+    d->meta = meta;
+    d->words = words;
+    d->map = NULL;
+    d->map_size = 0;
+    return 0;
+}
+
+int dict_load(struct dict *d, const char *path, int max_length)
+{
+    struct stat st;
+    void *map;
+    int fd, ret;
+
+    if((fd = open(path, O_RDONLY)) == -1) {
+        return -1;
+    }
+    if(fstat(fd, &st) == -1) {
+        (void) close(fd);
+        return -1;
+    }
+    if(st.st_size == 0) {
+        (void) close(fd);
+        return dict_filter(d, "", 0, max_length);
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    (void) close(fd);
+    if(map == MAP_FAILED) {
+        return -1;
+    }
+
+    if((size_t)st.st_size >= sizeof(struct dict_header) && memcmp(map, DICT_MAGIC, 8) == 0) {
+        const struct dict_header *h = map;
+        if(check(h, st.st_size, max_length) == -1) {
+            (void) munmap(map, st.st_size);
+            errno = EINVAL;
+            return -1;
+        }
+        d->bytes = (const char *)map + h->bytes;
+        d->bytes_size = h->bytes_size;
+        d->offsets = (const uint32_t *)((const char *)map + h->offsets);
+        d->meta = (const struct dict_meta *)((const char *)map + h->meta);
+        d->words = h->words;
+        d->map = map;
+        d->map_size = st.st_size;
+        return 0;
+    }
+
+    (void) madvise(map, st.st_size, MADV_SEQUENTIAL);
+    ret = dict_filter(d, map, st.st_size, max_length);
+    (void) munmap(map, st.st_size);
+    return ret;
+}
+
+void dict_free(struct dict *d)
+{
+    if(d->map != NULL) {
+        (void) munmap(d->map, d->map_size);
+    } else {
+        free((void *)d->bytes);
+        free((void *)d->offsets);
+        free((void *)d->meta);
+    }
+    (void) memset(d, 0, sizeof *d);
+}
+
+static int append(uint32_t **offsets, struct dict_meta **meta, uint32_t *words, uint32_t *capacity,
+                  uint32_t offset, const char *word, int length)
+{
+    if(*words == *capacity) {
+        uint32_t grown = *capacity > 0 ? *capacity * 2 : 1024;
+        uint32_t *o;
+        struct dict_meta *m;
+
+        if(*capacity > UINT32_MAX / 2) {
+            errno = EFBIG;
+            return -1;
+        }
+        if((o = realloc(*offsets, grown * sizeof *o)) == NULL) {
+            return -1;
+        }
+        *offsets = o;
+        if((m = realloc(*meta, grown * sizeof *m)) == NULL) {
+            return -1;
+        }
+        *meta = m;
+        *capacity = grown;
+    }
+
+    struct dict_meta *m = &(*meta)[*words];
+    (void) memset(m, 0, sizeof *m);
+    m->length = length;
+    for(int i=0; i<length; i++) {
+        if(word[i] != ' ') {
+            m->mask |= 1u << (word[i] - 'A');
+        }
+    }
+    (*offsets)[*words] = offset;
+    (*words)++;
+    return 0;
+}
+
+static int check(const struct dict_header *h, size_t size, int max_length)
+{
+    uint64_t words = h->words;
+
+    if(h->version != DICT_VERSION || h->max_length > (uint32_t)max_length
+       || h->offsets > size || words * sizeof(uint32_t) > size - h->offsets || h->offsets % 4 != 0
+       || h->meta > size || words * sizeof(struct dict_meta) > size - h->meta || h->meta % 4 != 0
+       || h->bytes > size || h->bytes_size > size - h->bytes
+       || (h->bytes_size > 0 && ((const char *)h)[h->bytes + h->bytes_size - 1] != '\0')) {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**hangman-dict
+  @author Michael Reitgruber, 1426100
+  @brief Word lists of the hangman server, filtered from text or mapped from a compiled dictionary
+  @detail A compiled dictionary, written by hangman-dictc, starts with a struct dict_header, followed by the offset
+          table, the metadata table and the NUL-terminated words, each section aligned to 8 bytes and in host byte
+          order. The server maps it read-only and shared, so it is used as is and several servers share its pages.
+  @date 18.10.2026
+  **/
+
+#ifndef HANGMAN_DICT_H
+#define HANGMAN_DICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DICT_MAGIC "HMDICT\r\n"
+#define DICT_VERSION 1
+
+//Start of a compiled dictionary, the offsets are file offsets
+struct dict_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t words; //number of words
+    uint32_t max_length; //characters of the longest word
+    uint32_t reserved;
+    uint64_t offsets; //uint32_t per word, the offset of the word in the word bytes
+    uint64_t meta; //struct dict_meta per word
+    uint64_t bytes; //the words, NUL-terminated one after another
+    uint64_t bytes_size;
+};
+
+//What the server needs to know about a word without looking at it
+struct dict_meta {
+    uint32_t mask; //bit i set if the word contains the letter 'A' + i
+    uint8_t length; //number of characters
+    uint8_t reserved[3];
+};
+
+//A loaded word list
+struct dict {
+    const char *bytes;
+    const uint32_t *offsets;
+    const struct dict_meta *meta;
+    uint32_t words;
+    size_t bytes_size;
+    void *map; //the mapped dictionary, or NULL if the tables are allocated
+    size_t map_size;
+};
+
+/**
+  * @brief filters a word list, one word per line, into allocated tables
+  * @detail Keeps letters, uppercased, and spaces; words are cut at max_length characters and skipped if empty
+  * @param d receives the word list
+  * @param text the word list
+  * @param size the length of the word list
+  * @param max_length the most characters of a word
+  * @return 0 on success, -1 on error with errno set
+  */
+int dict_filter(struct dict *d, const char *text, size_t size, int max_length);
+
+/**
+  * @brief loads a compiled dictionary, or filters a text word list
+  * @param d receives the word list
+  * @param path the file
+  * @param max_length the most characters of a word of a text list; a compiled dictionary with longer words is rejected
+  * @return 0 on success, -1 on error with errno set, EINVAL for a damaged or incompatible dictionary
+  */
+int dict_load(struct dict *d, const char *path, int max_length);
+
+/**
+  * @brief frees a word list
+  * @param d the word list
+  */
+void dict_free(struct dict *d);
+
+/**
+  * @brief returns a word of a list
+  * @detail The offsets of a compiled dictionary are not checked at loading, so a damaged one yields an empty word
+  * @param d the word list
+  * @param i the index of the word
+  * @return the word
+  */
+static inline const char *dict_word(const struct dict *d, uint32_t i)
+{
+    return d->offsets[i] < d->bytes_size ? d->bytes + d->offsets[i] : "";
+}
+
+#endif
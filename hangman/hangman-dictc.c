@@ -0,0 +1,142 @@
+/**hangman-dictc
+  @author Michael Reitgruber, 1426100
+  @brief Compiles a word list into a dictionary the hangman server maps without parsing
+  @detail Filters the list like the server does and writes header, offset table, metadata and word bytes, see
+          hangman-dict.h. The dictionary is written to a temporary file and renamed, so a running server keeps
+          the dictionary it mapped.
+  @date 18.10.2026
+  **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include "hangman-common.h"
+#include "hangman-dict.h"
+
+/*Alignment of the sections of a dictionary*/
+#define ALIGN 8
+
+static const char *progname = "hangman-dictc"; //name of the program
+static char *tmp_path = NULL; //the dictionary being written, removed on error
+
+/**
+  * Credit to the OSUE-Team
+  * @brief terminate program on program error
+  * @param exitcode exit code
+  * @param fmt format string
+  */
+static void bail_out(int exitcode, const char *fmt, ...);
+
+/**
+  * @brief writes a section of the dictionary, padded to the alignment
+  * @param f the dictionary
+  * @param data the section
+  * @param size the size of the section
+  */
+static void write_section(FILE *f, const void *data, size_t size);
+
+/**
+  * @brief returns the size of a section, padded to the alignment
+  * @param size the size of the section
+  * @return the padded size
+  */
+static uint64_t padded(uint64_t size);
+
+/**
+  * @brief Main entry point, compiles the word list given as first argument into the dictionary given as second
+  * @param argc number of arguments
+  * @param argv list of arguments
+  * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+  */
+int main(int argc, char *argv[])
+{
+    struct dict_header h;
+    struct dict d;
+    FILE *f;
+
+    if(argc > 0) {
+        progname = argv[0];
+    }
+    if(argc != 3) {
+        (void) fprintf(stderr, "Usage: %s <word-list> <dictionary>\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    if(dict_load(&d, argv[1], WORD_LENGTH - 1) == -1) {
+        bail_out(EXIT_FAILURE, "Error loading %s", argv[1]);
+    }
+
+    (void) memset(&h, 0, sizeof h);
+    (void) memcpy(h.magic, DICT_MAGIC, sizeof h.magic);
+    h.version = DICT_VERSION;
+    h.words = d.words;
+    for(uint32_t i=0; i<d.words; i++) {
+        if(d.meta[i].length > h.max_length) {
+            h.max_length = d.meta[i].length;
+        }
+    }
+    h.offsets = padded(sizeof h);
+    h.meta = h.offsets + padded((uint64_t)d.words * sizeof *d.offsets);
+    h.bytes = h.meta + padded((uint64_t)d.words * sizeof *d.meta);
+    h.bytes_size = d.bytes_size;
+
+    if((tmp_path = malloc(strlen(argv[2]) + 5)) == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating file name");
+    }
+    (void) sprintf(tmp_path, "%s.tmp", argv[2]);
+    if((f = fopen(tmp_path, "wb")) == NULL) {
+        bail_out(EXIT_FAILURE, "Error creating %s", tmp_path);
+    }
+    write_section(f, &h, sizeof h);
+    write_section(f, d.offsets, (size_t)d.words * sizeof *d.offsets);
+    write_section(f, d.meta, (size_t)d.words * sizeof *d.meta);
+    write_section(f, d.bytes, d.bytes_size);
+    if(fclose(f) != 0) {
+        bail_out(EXIT_FAILURE, "Error writing %s", tmp_path);
+    }
+    if(rename(tmp_path, argv[2]) == -1) {
+        bail_out(EXIT_FAILURE, "Error renaming %s to %s", tmp_path, argv[2]);
+    }
+    free(tmp_path);
+    tmp_path = NULL;
+
+    (void) printf("%u words, longest %u characters\n", h.words, h.max_length);
+    dict_free(&d);
+    return EXIT_SUCCESS;
+}
+
+static void write_section(FILE *f, const void *data, size_t size)
+{
+    static const char zeros[ALIGN] = {0};
+
+    if((size > 0 && fwrite(data, size, 1, f) != 1)
+       || (padded(size) > size && fwrite(zeros, padded(size) - size, 1, f) != 1)) {
+        bail_out(EXIT_FAILURE, "Error writing %s", tmp_path);
+    }
+}
+
+static uint64_t padded(uint64_t size)
+{
+    return (size + ALIGN - 1) / ALIGN * ALIGN;
+}
+
+static void bail_out(int exitcode, const char *fmt, ...)
+{
+    va_list ap;
+    (void) fprintf(stderr, "%s: ", progname);
+    if(fmt != NULL) {
+        va_start(ap, fmt);
+        (void) vfprintf(stderr, fmt, ap);
+        va_end(ap);
+    }
+    if(errno != 0) {
+        (void) fprintf(stderr, ": %s", strerror(errno));
+    }
+    (void)fprintf(stderr, "\n");
+
+    if(tmp_path != NULL) {
+        (void) remove(tmp_path);
+    }
+    exit(exitcode);
+}
@@ -0,0 +1,226 @@
+/**hangman-queue
+  @author Michael Reitgruber, 1426100
+  @brief Implements the request ring and the doorbells of the hangman shared memory
+  @detail The ring follows the bounded queue of Dmitry Vyukov: every cell carries a sequence number telling whether it
+          is free for the producer of a position or published for the consumer. The futex words are shared between
+          processes, so the futex calls must not be private.
+  @date 18.10.2026
+  **/
+
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "hangman-queue.h"
+
+/*Bounds of the number of polls before sleeping*/
+#define MIN_SPIN 16
+#define MAX_SPIN 4096
+
+//polls before sleeping, doubled when a spin succeeds and halved when it did not, -1 until initialized; shared by the
+//threads of a process, a lost update only costs a poll too many or too few
+static int spin = -1;
+
+/**
+  * @brief sleeps while a futex word has a value
+  * @param word the futex word
+  * @param val the value
+  * @return 0 when woken, -1 with errno EAGAIN if the word changed, EINTR if interrupted
+  */
+static int futex_wait(uint32_t *word, uint32_t val);
+
+/**
+  * @brief wakes the waiters of a futex word
+  * @param word the futex word
+  * @param count most waiters to wake
+  */
+static void futex_wake(uint32_t *word, int count);
+
+/**
+  * @brief hints the processor that this is a spin loop
+  */
+static inline void cpu_relax(void);
+
+/**
+  * @brief returns how often to poll before sleeping
+  * @detail Polling is useless on a single processor, the other side cannot run meanwhile
+  * @return the number of polls
+  */
+static int spin_limit(void);
+
+/**
+  * @brief adapts the number of polls to the outcome of the last spin
+  * @param success whether the spin ended without sleeping
+  */
+static void spin_adapt(int success);
+
+/**
+  * @brief checks whether the ring holds an entry for the consumer
+  * @param r the ring
+  * @return 1 if so, 0 else
+  */
+static int ring_ready(struct ring *r);
+
+void ring_init(struct ring *r)
+{
+    r->head = 0;
+    r->tail = 0;
+    r->sleeping = BELL_IDLE;
+    for(uint32_t i=0; i<RING_SIZE; i++) {
+        r->cells[i].seq = i;
+    }
+}
+
+void ring_push(struct ring *r, int slot)
+{
+    uint32_t pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+
+    for(;;) {
+        uint32_t seq = __atomic_load_n(&r->cells[pos % RING_SIZE].seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if(diff == 0) {
+            if(__atomic_compare_exchange_n(&r->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if(diff < 0) {
+            /* full, cannot happen with one request per client */
+            (void) sched_yield();
+            pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+        } else {
+            pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+        }
+    }
+    r->cells[pos % RING_SIZE].slot = slot;
+    __atomic_store_n(&r->cells[pos % RING_SIZE].seq, pos + 1, __ATOMIC_RELEASE);
+
+    /* pairs with the fence of a consumer going to sleep: either it sees the entry, or we see it sleeping */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&r->sleeping, __ATOMIC_RELAXED) == BELL_SLEEPING
+       && __atomic_exchange_n(&r->sleeping, BELL_IDLE, __ATOMIC_SEQ_CST) == BELL_SLEEPING) {
+        futex_wake(&r->sleeping, 1);
+    }
+}
+
+int ring_pop(struct ring *r, int *slot)
+{
+    uint32_t pos = r->tail;
+
+    if(!ring_ready(r)) {
+        return -1;
+    }
+    *slot = r->cells[pos % RING_SIZE].slot;
+    __atomic_store_n(&r->cells[pos % RING_SIZE].seq, pos + RING_SIZE, __ATOMIC_RELEASE);
+    r->tail = pos + 1;
+    return 0;
+}
+
+int ring_wait(struct ring *r)
+{
+    int limit = spin_limit();
+
+    for(int i=0; i<limit; i++) {
+        if(ring_ready(r)) {
+            spin_adapt(1);
+            return 0;
+        }
+        cpu_relax();
+    }
+    if(limit > 0) {
+        spin_adapt(0);
+    }
+
+    __atomic_store_n(&r->sleeping, BELL_SLEEPING, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(!ring_ready(r) && futex_wait(&r->sleeping, BELL_SLEEPING) == -1 && errno == EINTR) {
+        __atomic_store_n(&r->sleeping, BELL_IDLE, __ATOMIC_RELAXED);
+        return -1;
+    }
+    __atomic_store_n(&r->sleeping, BELL_IDLE, __ATOMIC_RELAXED);
+    return 0;
+}
+
+void bell_reset(uint32_t *bell)
+{
+    __atomic_store_n(bell, BELL_IDLE, __ATOMIC_RELAXED);
+}
+
+void bell_ring(uint32_t *bell)
+{
+    if(__atomic_exchange_n(bell, BELL_RUNG, __ATOMIC_RELEASE) == BELL_SLEEPING) {
+        futex_wake(bell, 1);
+    }
+}
+
+void bell_wait(uint32_t *bell)
+{
+    uint32_t expected = BELL_IDLE;
+    int limit = spin_limit();
+
+    for(int i=0; i<limit; i++) {
+        if(__atomic_load_n(bell, __ATOMIC_ACQUIRE) == BELL_RUNG) {
+            spin_adapt(1);
+            return;
+        }
+        cpu_relax();
+    }
+    if(limit > 0) {
+        spin_adapt(0);
+    }
+
+    /* announce the sleep unless the bell rang meanwhile, then sleep until it rings */
+    if(!__atomic_compare_exchange_n(bell, &expected, BELL_SLEEPING, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    while(__atomic_load_n(bell, __ATOMIC_ACQUIRE) != BELL_RUNG) {
+        (void) futex_wait(bell, BELL_SLEEPING);
+    }
+}
+
+static int ring_ready(struct ring *r)
+{
+    uint32_t pos = r->tail;
+
+    return __atomic_load_n(&r->cells[pos % RING_SIZE].seq, __ATOMIC_ACQUIRE) == pos + 1;
+}
+
+static int futex_wait(uint32_t *word, uint32_t val)
+{
+    return syscall(SYS_futex, word, FUTEX_WAIT, val, NULL, NULL, 0) == -1 ? -1 : 0;
+}
+
+static void futex_wake(uint32_t *word, int count)
+{
+    (void) syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static int spin_limit(void)
+{
+    int limit = __atomic_load_n(&spin, __ATOMIC_RELAXED);
+
+    if(limit == -1) {
+        limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? MIN_SPIN : 0;
+        __atomic_store_n(&spin, limit, __ATOMIC_RELAXED);
+    }
+    return limit;
+}
+
+static void spin_adapt(int success)
+{
+    int limit = __atomic_load_n(&spin, __ATOMIC_RELAXED);
+
+    if(success) {
+        limit = limit * 2 < MAX_SPIN ? limit * 2 : MAX_SPIN;
+    } else {
+        limit = limit / 2 > MIN_SPIN ? limit / 2 : MIN_SPIN;
+    }
+    __atomic_store_n(&spin, limit, __ATOMIC_RELAXED);
+}
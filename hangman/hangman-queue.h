@@ -0,0 +1,86 @@
+/**hangman-queue
+  @author Michael Reitgruber, 1426100
+  @brief Lock-free request ring and doorbells in the hangman shared memory
+  @detail Clients push the index of their mailbox slot to a multi-producer single-consumer ring, the server answers by
+          ringing the doorbell of the slot. Both sides spin briefly before they sleep on a futex, so a wait only costs
+          a system call if the other side is really slow; the spin adapts to how often it succeeds.
+  @date 18.10.2026
+  **/
+
+#ifndef HANGMAN_QUEUE_H
+#define HANGMAN_QUEUE_H
+
+#include <stdint.h>
+
+/*Number of entries of the request ring, a power of two; every client has at most one request queued, so the ring
+  never fills up as long as it is larger than MAX_CLIENTS*/
+#define RING_SIZE 8192
+
+/*Ring entry of a CONNECT request*/
+#define CONNECT_SLOT (-1)
+
+/*States of a doorbell and of the ring's consumer, the futex words*/
+#define BELL_IDLE 0
+#define BELL_RUNG 1
+#define BELL_SLEEPING 2
+
+//Multi-producer single-consumer ring of slot indices
+struct ring {
+    uint32_t head; //next position to reserve, shared by the producers
+    char pad1[60]; //keep the consumer's words off the producers' cache line
+    uint32_t tail; //next position to read, only written by the consumer
+    uint32_t sleeping; //BELL_SLEEPING while the consumer sleeps
+    char pad2[56];
+    struct {
+        uint32_t seq; //position + 1 once the entry is published, position + RING_SIZE once it is consumed
+        int32_t slot;
+    } cells[RING_SIZE];
+};
+
+/**
+  * @brief initializes an empty ring
+  * @param r the ring
+  */
+void ring_init(struct ring *r);
+
+/**
+  * @brief queues a slot and wakes the consumer if it sleeps
+  * @param r the ring
+  * @param slot index of the slot, or CONNECT_SLOT
+  */
+void ring_push(struct ring *r, int slot);
+
+/**
+  * @brief takes the oldest entry of the ring, only called by the consumer
+  * @param r the ring
+  * @param slot receives the entry
+  * @return 0 on success, -1 if the ring is empty
+  */
+int ring_pop(struct ring *r, int *slot);
+
+/**
+  * @brief waits until the ring holds an entry, only called by the consumer
+  * @param r the ring
+  * @return 0 if an entry is available, -1 if interrupted by a signal
+  */
+int ring_wait(struct ring *r);
+
+/**
+  * @brief resets a doorbell before the request it answers is sent
+  * @param bell the doorbell
+  */
+void bell_reset(uint32_t *bell);
+
+/**
+  * @brief rings a doorbell, waking its waiter
+  * @param bell the doorbell
+  */
+void bell_ring(uint32_t *bell);
+
+/**
+  * @brief waits until a doorbell rings, signals do not end the wait
+  * @param bell the doorbell
+  */
+void bell_wait(uint32_t *bell);
+
+#endif
@@ -2,6 +2,14 @@
   @author Michael Reitgruber, 1426100
   @brief Implements a server for the game hangman
   @detail Uses shared memory objects, to serve hangman games to a arbitrary number of clients, takes a wordlist as a file, or words from stdin
+          Every client gets its own mailbox slot in the shared memory at CONNECT, so clients never wait for each other;
+          a client pushes the index of its slot to the request ring once its request is in the slot, the server
+          drains all queued requests per wakeup and answers by ringing the slot's doorbell
+          With -t the requests are served by a pool of worker threads; every worker has its own request ring and owns
+          the clients whose number is congruent to its index, so workers never share a client record. The word list
+          is only read after loading, and every client plays the words in list order whichever worker serves it
+          The input file is either a word list, filtered in one pass into a single arena, or a dictionary compiled by
+          hangman-dictc, which is mapped as is
   @date 08.12.2015
   **/
 
@@ -18,34 +26,55 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <semaphore.h>
+#include <pthread.h>
+#include <limits.h>
+#include <stdint.h>
 #include "hangman-common.h"
+#include "hangman-dict.h"
+
+/*Ring entry telling a worker to stop*/
+#define STOP_SLOT (-2)
+
+/*End of the free list*/
+#define NO_CLIENT (-1)
+
+/*Bit of a letter in a letter mask, 0 if the character is no letter*/
+#define LETTER_BIT(c) ((c) >= 'A' && (c) <= 'Z' ? 1u << ((c) - 'A') : 0u)
 
 
 
 
 typedef struct {
-    int cno;
+    int cno; //generation * MAX_CLIENTS + index in the client table, NO_CLIENT while free
+    unsigned int generation; //incremented whenever the record is reused, so stale client numbers are not found
+    int next_free; //next record of the free list
     int mistakes;
     int used_words;
     int wins;
     int losses;
     char current_word[WORD_LENGTH]; 
-    char guessed_letters[26];
+    uint32_t word_mask; //letters of current_word, bit i for 'A' + i
+    uint32_t guessed; //letters guessed so far, same bits
 }client; //structure which holds client information
 
-static client **client_list = NULL; //list of connected clients
-static int connected_clients = 0; //number of connected clients
-static int hi_client_number=0; //current highest client number
+//A thread serving the requests of one partition of the clients
+struct worker {
+    pthread_t thread;
+    struct ring *ring; //requests of the clients with cno % worker_count == index, and CONNECT for worker 0
+};
+
+static struct worker *workers = NULL; //the workers, the main thread is worker 0
+static int worker_count = 1; //number of workers
+
+static client *client_table = NULL; //one record per mailbox slot, allocated at once
+static int free_head = NO_CLIENT; //first free record; pushed by any worker, popped only by worker 0
 
-static char **word_list = NULL; //list of words available for play
+static struct dict dict; //the words available for play
 static int words = 0; //number of words
 
 static int shmfd = -1; //shared memory file descriptor
 static const char *progname = "hangman-server"; //name of the program
-static struct comm *shared; //pointer to shared memory
-static sem_t *sem_serv;
-static sem_t *sem_client;
-static sem_t *sem_comm;
+static struct shm *shm = MAP_FAILED; //pointer to shared memory
 
 static volatile sig_atomic_t want_quit = 0;
 
@@ -63,29 +92,28 @@ static void bail_out(int exitcode, const char *fmt, ...);
 static void free_resources(void);
 
 /**
-  * @brief adds a new client to the list
-  * @param c the client to be added
+  * @brief takes a record off the free list and starts a new client in it, only called by worker 0
+  * @return the client, or NULL if all records are in use
   */
-static void add_client(client *c);
+static client *add_client(void);
 
 /**
-  * @brief searches for the client with the specified client number
+  * @brief looks up the client with the specified client number
   * @param cno The number of the client to find
-  * @return a pointer to the client, or NULL if not found
+  * @return a pointer to the client, or NULL if the number is not in use
   */
 static client *find_client(int cno);
 
 /**
-  * @brief searches for the client with the specified client number and removes it
-  * @param cno The number of the client to remove
+  * @brief ends a client and puts its record back on the free list
+  * @param c The client to remove
   */
-static void remove_client(int cno);
+static void remove_client(client *c);
 
 /**
-  * @brief creates a new client, to be stored in the client list
-  * @param client_number The number of the client
+  * @brief allocates the client table, all records free
   */
-static client *create_client(int client_number);
+static void create_client_table(void);
 
 /**
   * @brief allocates all necessary resources
@@ -93,19 +121,37 @@ static client *create_client(int client_number);
 static void allocate_resources(void);
 
 /**
-  * @brief waits for semaphore and checks for errors
-  * @param sem the semaphore to wait for
+  * @brief assigns a free slot and a client number to a connecting client
+  * @detail Only worker 0 handles CONNECT; the slot's index is the index of the client's record
+  */
+static void handle_connect(void);
+
+/**
+  * @brief handles the request in a slot, ignores entries that are not a slot
+  * @param w the worker that popped the request
+  * @param slot index of the slot
+  */
+static void handle_request(const struct worker *w, int slot);
+
+/**
+  * @brief The procedure of a worker, serves the requests on its ring
+  * @param arg the worker
+  * @return NULL once stopped
+  */
+static void *serve(void *arg);
+
+/**
+  * @brief starts the workers other than the main thread, they do not receive signals
   */
-static void cwait(sem_t *sem);
+static void start_workers(void);
 
 /**
-  * @brief posts to semaphore and checks for errors
-  * @param sem the semaphore to post to
+  * @brief stops the workers other than the main thread and waits for them
   */
-static void cpost(sem_t *sem);
+static void stop_workers(void);
 
 /**
-  * @brief frees all stored clients
+  * @brief frees the client table and the workers
   */
 static void free_client_list(void);
 
@@ -115,10 +161,10 @@ static void free_client_list(void);
 static void free_word_list(void);
 
 /**
-  * @brief adds a word to the wordlist
-  * @param word the word to be added
+  * @brief reads a word list from a stream up to EOF and filters it
+  * @param f the stream
   */
-static void add_word(char *word);
+static void read_words(FILE *f);
 
 /**
   * @brief Signal handler, gracefully exits the program on SIGINT or SIGTERM
@@ -128,41 +174,27 @@ static void handle_signal(int signal);
 
 /**
   * @brief Prepares the shared memory for communication with the client
+  * @param shared The mailbox of the client
   * @param client The client currently communicating with the server
   */
-static void prepare_mem(client *c);
+static void prepare_mem(struct comm *shared, client *c);
 
 /**
-  * @brief checks if a guessed letter is in the clients word;
-  * @param guess the guessed letter
+  * @brief plays one letter of a client's game, the response becomes WON or LOST if it ends the game
+  * @param shared the mailbox of the client
   * @param c the client
-  * @return 1 if letter is in the word, 0 else
-  */
-static int valid(char guess, client *c);
-
-/**
-  * @brief reveals part of the word
-  * @param rword the word to reveal
-  * @param cword the word to guess
-  * @param letters the already guessed letters
-  */
-static int reveal(char *cword, char *letters);
-
-/**
-  * @brief checks if the guessed_letters array contains a letter
-  * @param letter the letter to check for
-  * @param arr the array to go through
-  * @param length the array length
+  * @param letter the guessed letter
+  * @return 1 if the letter is in the word, 0 else
   */
-static int contains(char letter, char *arr);
+static int play(struct comm *shared, client *c, char letter);
 
 /**
-  * @brief filters non-letter (and non-space) characters out of words
-  * @param word the word to filter
-  * @param length the length of the word to filter
-  * @return a pointer to the filtered string
+  * @brief makes every position of a character in the word visible
+  * @param shared the mailbox receiving the positions
+  * @param c the client
+  * @param letter the character
   */
-static char *filter(char *word, int length);
+static void reveal(struct comm *shared, client *c, char letter);
 
 /**
   * @brief Main entry point for the program, handles game logic
@@ -192,54 +224,42 @@ int main(int argc, char *argv[])
         progname = argv[0];
     }
 
-    int max_length = 0;
-    FILE *f;
-    if(argc == 2) {
-        f = fopen(argv[1], "r");
-        if(f == NULL) {
+    int opt;
+    char *endptr;
+    while((opt = getopt(argc, argv, "t:")) != -1) {
+        switch(opt) {
+        case 't':
+            errno = 0;
+            worker_count = (int)strtol(optarg, &endptr, 10);
+            if(errno != 0 || *endptr != '\0' || worker_count < 1 || worker_count > MAX_WORKERS) {
+                bail_out(EXIT_FAILURE, "Number of workers has to be between 1 and %d", MAX_WORKERS);
+            }
+            break;
+        default:
+            (void) fprintf(stderr, "Usage: %s [-t workers] [input_file]\n", progname);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(argc - optind == 1) {
+        if(dict_load(&dict, argv[optind], WORD_LENGTH - 1) == -1) {
             bail_out(EXIT_FAILURE, "Invalid input file");
         }
     }
-    else if(argc == 1) {
-        f = stdin;
+    else if(argc == optind) {
+        (void) printf("\nEnter words to guess line by line (quit with CTRL+D): \n");
+        read_words(stdin);
     }
     else {
-        (void) fprintf(stderr, "Usage: %s [input_file]", progname);
+        (void) fprintf(stderr, "Usage: %s [-t workers] [input_file]\n", progname);
         exit(EXIT_FAILURE);
     }
-
-
-    int read=0;
-    char *line = (char *)malloc(sizeof(char)*(WORD_LENGTH + 1));
-    char *point = NULL;
-    if(argc == 1) {
-        (void) printf("\nEnter words to guess line by line (quit with CTRL+D): \n");
-    }
-    while((point = fgets(line, WORD_LENGTH+1, f))!=NULL) {
-        (void) fflush(stdin);
-        read = strlen(line);
-        if(read > max_length) {
-            max_length = read;
-            if(line[read-1] == '\n') {
-                max_length --; //don't count \n
-            }
-        }
-        if(line[read-1] == '\n') {
-            line[read-1] = '\0'; //remove trailing \n
-        }
-        if(strlen(line) == 0)
-            continue;
-        add_word(filter(line, strlen(line)));
-    }
+    words = dict.words;
     if(words == 0) {
+        errno = 0;
         bail_out(EXIT_FAILURE, "Use at least one word");
     }
     (void) printf("\nWaiting for connections\n");
-    if(argc == 2) { //only close if it's a file, don't close stdin
-        (void) fclose(f);
-    }
-    if(line)
-        free(line);
     
 
 
@@ -247,126 +267,190 @@ int main(int argc, char *argv[])
         bail_out(EXIT_FAILURE, "Error setting cleanup function on exit");
     }
 
+    create_client_table();
     allocate_resources();
-    client *c;
+    start_workers();
           
+    (void) serve(&workers[0]);
+    stop_workers();
+    
+    return EXIT_SUCCESS;
+}
+
+static void *serve(void *arg)
+{
+    struct worker *w = arg;
+    int slot;
+
     while(!want_quit) { 
-        cwait(sem_serv);
-        if(errno == EINTR) continue;
-
-        switch(shared->rtype) {
-        case CONNECT:
-            c = create_client(hi_client_number);
-            shared->cno = hi_client_number;
-            hi_client_number++;
-            add_client(c);
-            cpost(sem_comm);
-            cwait(sem_serv);
-            if(errno == EINTR) continue;
-            break;
-        case DISCONNECT:
-            remove_client(shared->cno);
-            break;
-        case NEW:
-            c = find_client(shared->cno);
-            if(c->used_words == words) {
-                shared->rtype = NO_MORE_WORDS;
-                cpost(sem_comm);
-                remove_client(shared->cno);
-                break;
-            }
-            for(int i=0; i<26; i++) {
-                c->guessed_letters[i] = 0;
-            }
-            (void) strcpy(c->current_word, word_list[c->used_words]);
-            c->used_words++;
-            c->mistakes = 0;
-            cpost(sem_comm);
-            break;
-        case PLAY:
-            c = find_client(shared->cno);
-            prepare_mem(c);
-            (void) strcpy(shared->word, c->current_word);
-            char guess = (char)toupper(shared->guess); 
-            c->guessed_letters[guess-'A'] = 1; //index of guessed letter in alphabet
-            
-            if(valid(guess, c)) {
-               int done = reveal(c->current_word, c->guessed_letters);
-               if(done == 1) {
-                   shared->rtype = WON;
-                   c->wins++;
-               }
-            }
-            else {
-                if(c->mistakes == 8) {
-                    shared->rtype = LOST;     
-                     c->losses++;
+        if(ring_wait(w->ring) == -1) continue;
+
+        /* serve everything queued before sleeping again */
+        while(ring_pop(w->ring, &slot) == 0) {
+            if(slot == STOP_SLOT) {
+                return NULL;
+            } else if(slot == CONNECT_SLOT) {
+                if(w == workers) { //the free list has a single popper
+                    handle_connect();
                 }
-
-                c->mistakes++;
-                (void) reveal(c->current_word, c->guessed_letters);
+            } else {
+                handle_request(w, slot);
             }
-            
-            prepare_mem(c);
-            cpost(sem_comm);
-           
-            break;
-        default:
-            assert(0);
         }
-        cpost(sem_client);   
     }
-
-
-    
-    return EXIT_SUCCESS;
+    return NULL;
 }
 
+static void start_workers(void)
+{
+    sigset_t all, old;
 
-static char *filter(char *line, int length){
-    int valids = 0;
-    char *filtered = NULL;
-    for(int i=0; i<length; i++) {
-        if((toupper(line[i])>='A' && toupper(line[i])<='Z') || line[i] == ' ') {
-            valids ++;
-        }
+    workers = (struct worker *)calloc(worker_count, sizeof(struct worker));
+    if(workers == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating workers");
+    }
+    for(int i=0; i<worker_count; i++) {
+        workers[i].ring = &shm->rings[i];
     }
 
-    filtered = (char *)malloc(sizeof(char)*valids+1);
-    if(filtered == NULL) {
-        bail_out(EXIT_FAILURE, "Error allocating space for filtered string");
+    /* the threads inherit the blocked signals, so SIGINT and SIGTERM reach the main thread */
+    if(sigfillset(&all) < 0 || pthread_sigmask(SIG_BLOCK, &all, &old) != 0) {
+        bail_out(EXIT_FAILURE, "Error blocking signals");
     }
-    int j=0;
-    for(int i=0; i<length; i++) {
-        if((toupper(line[i])>='A' && toupper(line[i])<='Z') || line[i] == ' ') {
-            filtered[j] = toupper(line[i]);
-            j++;
+    for(int i=1; i<worker_count; i++) {
+        if((errno = pthread_create(&workers[i].thread, NULL, serve, &workers[i])) != 0) {
+            bail_out(EXIT_FAILURE, "Error starting worker");
         }
     }
-    filtered[j] = '\0';
-    return filtered;
+    if(pthread_sigmask(SIG_SETMASK, &old, NULL) != 0) {
+        bail_out(EXIT_FAILURE, "Error unblocking signals");
+    }
 }
-static void cwait(sem_t *sem) {
-    if(sem_wait(sem) == -1) {
-        if(errno != EINTR) {
-            bail_out(EXIT_FAILURE, "Error waiting on semaphore");
-        }
+
+static void stop_workers(void)
+{
+    for(int i=1; i<worker_count; i++) {
+        ring_push(workers[i].ring, STOP_SLOT);
+    }
+    for(int i=1; i<worker_count; i++) {
+        (void) pthread_join(workers[i].thread, NULL);
     }
 }
 
-static void cpost(sem_t *sem) {
-    if(sem_post(sem) == -1) {
-        bail_out(EXIT_FAILURE, "Error posting to semaphore");
+static void handle_connect(void)
+{
+    client *c = add_client();
+
+    if(c == NULL) {
+        shm->connect.rtype = SERVER_FULL;
+    } else {
+        int slot = c - client_table;
+        shm->slots[slot].in_use = 1;
+        shm->slots[slot].comm.cno = c->cno;
+        shm->connect.cno = slot;
+    }
+    bell_ring(&shm->connect_bell);
+}
+
+static void handle_request(const struct worker *w, int slot)
+{
+    struct slot *s;
+    struct comm *shared;
+    client *c;
+    int cno, i;
+
+    if(slot < 0 || slot >= MAX_CLIENTS) {
+        return; //not a mailbox, nobody to answer
+    }
+    s = &shm->slots[slot];
+    shared = &s->comm;
+    cno = shared->cno;
+
+    /* a client queues only in its own slot on the ring of its worker, else two workers would share its record */
+    c = cno % worker_count == w - workers && cno % MAX_CLIENTS == slot ? find_client(cno) : NULL;
+    if(c == NULL) {
+        /* the client number is stale or misrouted */
+        if(shared->rtype != DISCONNECT) {
+            shared->rtype = NO_MORE_WORDS;
+            bell_ring(&s->bell);
+        }
+        return;
+    }
+    switch(shared->rtype) {
+    case DISCONNECT:
+        s->in_use = 0;
+        remove_client(c); //handle_connect may reuse the slot on worker 0 from now on
+        return; //nobody waits for the response
+    case NEW:
+        if(c->used_words == words) {
+            shared->rtype = NO_MORE_WORDS;
+            break;
+        }
+        c->guessed = 0;
+        c->word_mask = dict.meta[c->used_words].mask;
+        (void) strncpy(c->current_word, dict_word(&dict, c->used_words), WORD_LENGTH - 1);
+        c->used_words++;
+        c->mistakes = 0;
+        shared->length = strlen(c->current_word);
+        shared->revealed = 0;
+        reveal(shared, c, ' ');
+        prepare_mem(shared, c);
+        break;
+    case PLAY:
+        (void) play(shared, c, shared->guess);
+        prepare_mem(shared, c);
+        break;
+    case PLAY_BATCH:
+        shared->hits = 0;
+        for(i=0; i<shared->batch && i<MAX_BATCH && shared->rtype == PLAY_BATCH; i++) {
+            if(play(shared, c, shared->guesses[i])) {
+                shared->hits |= 1u << i;
+            }
+        }
+        shared->batch = i;
+        prepare_mem(shared, c);
+        break;
+    default:
+        assert(0);
     }
+    bell_ring(&s->bell);
 }
 
+
+static void read_words(FILE *f)
+{
+    size_t size = 0, capacity = 4096, n;
+    char *text = (char *)malloc(capacity);
+
+    if(text == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating input buffer");
+    }
+    while((n = fread(text + size, 1, capacity - size, f)) > 0) {
+        size += n;
+        if(size == capacity) {
+            char *tmp = (char *)realloc(text, capacity * 2);
+            if(tmp == NULL) {
+                bail_out(EXIT_FAILURE, "Error extending input buffer");
+            }
+            text = tmp;
+            capacity *= 2;
+        }
+    }
+    if(ferror(f)) {
+        bail_out(EXIT_FAILURE, "Error reading words");
+    }
+    if(dict_filter(&dict, text, size, WORD_LENGTH - 1) == -1) {
+        bail_out(EXIT_FAILURE, "Error filtering words");
+    }
+    free(text);
+}
 static void bail_out(int exitcode, const char *fmt, ...)
 {
     va_list ap;
     (void) fprintf(stderr, "%s: ", progname);
     if(fmt != NULL) {
         va_start(ap, fmt);
-        (void) fprintf(stderr, fmt, ap);
+        (void) vfprintf(stderr, fmt, ap);
         va_end(ap);
     }
     if(errno != 0) {
@@ -379,112 +463,100 @@ static void bail_out(int exitcode, const char *fmt, ...)
 }
 
 static void free_resources() {
-    shared->terminate = 1;
-    (void)sem_post(sem_client);
     free_word_list();
     free_client_list();
-    if(munmap(shared, sizeof *shared) == -1) {
-        (void) fprintf(stderr, "Error unmapping shared memory");
+    if(shm != MAP_FAILED) {
+        /* wake every client, they see terminate; connect_lock is not destroyed as clients may still use it */
+        __atomic_store_n(&shm->terminate, 1, __ATOMIC_SEQ_CST);
+        bell_ring(&shm->connect_bell);
+        for(int i=0; i<MAX_CLIENTS; i++) {
+            if(shm->slots[i].in_use) {
+                bell_ring(&shm->slots[i].bell);
+            }
+        }
+        if(munmap(shm, sizeof *shm) == -1) {
+            (void) fprintf(stderr, "Error unmapping shared memory");
+        }
     }
     if(shmfd != -1) {
         if(shm_unlink(SHM_NAME) == -1) {
            (void) fprintf(stderr, "Error unlinking shared memory object");
         }
     }
-    if(sem_close(sem_serv) == -1) {
-        (void) fprintf(stderr, "Error closing semaphore %s", SEM_SERV_NAME);
-    }
-    if(sem_close(sem_client) == -1) {
-        (void) fprintf(stderr, "Error closing semaphore %s", SEM_CLIENT_NAME);
-    }
-    if(sem_close(sem_comm) == -1) {
-        (void) fprintf(stderr, "Error closing semaphore %s", SEM_COMM_NAME);
-    }
-    if(sem_unlink(SEM_COMM_NAME) == -1) {
-        (void) fprintf(stderr, "Error unlinking semaphore %s", SEM_COMM_NAME);
-    }
-    if(sem_unlink(SEM_SERV_NAME) == -1) {
-        (void) fprintf(stderr, "Error unlinking semaphore %s", SEM_SERV_NAME);
+}
+
+static void create_client_table(void)
+{
+    client_table = (client *)calloc(MAX_CLIENTS, sizeof(client));
+    if(client_table == NULL) {
+        bail_out(EXIT_FAILURE, "Error allocating memory for client data");
     }
-    if(sem_unlink(SEM_CLIENT_NAME) == -1) {
-        (void) fprintf(stderr, "Error unlinking semaphore %s", SEM_CLIENT_NAME);
+    for(int i=0; i<MAX_CLIENTS; i++) {
+        client_table[i].cno = NO_CLIENT;
+        client_table[i].next_free = i + 1 < MAX_CLIENTS ? i + 1 : NO_CLIENT;
     }
+    free_head = 0;
 }
 
-static client *create_client(int client_number)
+static client *add_client(void)
 {
-    client *newC = (client *)malloc(sizeof(client));
-    if(newC == NULL) {
-        bail_out(EXIT_FAILURE, "Error allocating memory for client data");
+    int index = __atomic_load_n(&free_head, __ATOMIC_ACQUIRE);
+
+    /* the only consumer, so a record seen at the head stays there until this takes it */
+    while(index != NO_CLIENT && !__atomic_compare_exchange_n(&free_head, &index, client_table[index].next_free, 0,
+                                                             __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    if(index == NO_CLIENT) {
+        return NULL;
     }
-    newC->cno=client_number;
+
+    client *newC = &client_table[index];
+    newC->generation = (newC->generation + 1) % (INT_MAX / MAX_CLIENTS);
+    newC->cno = newC->generation * MAX_CLIENTS + index;
     newC->mistakes = 0;
     newC->used_words = 0;
     newC->wins = 0;
     newC->losses = 0;
-    for(int i=0; i<26; i++) {
-        newC->guessed_letters[i] = 0;
-    }
+    newC->word_mask = 0;
+    newC->guessed = 0;
 
     return newC;
 }
 
-static void add_client(client *c)
-{
-    client **tmp = (client **)realloc(client_list, (connected_clients+1)*(sizeof(client*)));
-    if(tmp == NULL) {
-        bail_out(EXIT_FAILURE, "Error extending client list");
-    }
-    client_list = tmp;
-    client_list[connected_clients] = c; //no need to write +1 here, because of zero-based indexing
-    connected_clients++;
-}
-
 static client *find_client(int cno)
 {
-    for(int i=0; i<connected_clients; i++) {
-        if(client_list[i]->cno == cno) {
-            return client_list[i];
-        }
+    if(cno < 0 || client_table[cno % MAX_CLIENTS].cno != cno) {
+        return NULL;
     }
-    return NULL;
+    return &client_table[cno % MAX_CLIENTS];
 }
 
-static void remove_client(int cno)
+static void remove_client(client *c)
 {
-    for(int i=0; i<connected_clients; i++) {
-        if(client_list[i]->cno == cno) {
-            free(client_list[i]);
-            for(int j=i; j<connected_clients-1; j++) {
-                client_list[j] = client_list[j+1];
-            }
-            connected_clients--;
-            client **tmp = (client **)realloc(client_list, (connected_clients)*sizeof(client*));
-            if(tmp == NULL && connected_clients != 0) {
-                bail_out(EXIT_FAILURE, "Error shrinking client list");
-            }
-            client_list = tmp;
-            break;
-        }
-    }
+    int index = c - client_table;
+    int head = __atomic_load_n(&free_head, __ATOMIC_RELAXED);
+
+    c->cno = NO_CLIENT;
+    do {
+        c->next_free = head;
+    } while(!__atomic_compare_exchange_n(&free_head, &head, index, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
 }
 
 static void allocate_resources()
 {
 
-    shmfd = shm_open(SHM_NAME, O_RDWR | O_CREAT, PERM); 
+    shmfd = shm_open(SHM_NAME, O_RDWR | O_CREAT | O_EXCL, PERM); 
     
     if(shmfd == -1) {
         bail_out(EXIT_FAILURE, "Error creating shared memory");
     }
     
-    if(ftruncate(shmfd, sizeof *shared) == -1) {
+    if(ftruncate(shmfd, sizeof *shm) == -1) {
         bail_out(EXIT_FAILURE, "Error setting size of shared memory");
     }
 
-    shared = mmap(NULL, sizeof *shared, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+    shm = mmap(NULL, sizeof *shm, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
 
-    if(shared == MAP_FAILED) {
+    if(shm == MAP_FAILED) {
         bail_out(EXIT_FAILURE, "Mapping shared memory failed");
     }
 
@@ -492,57 +564,29 @@ static void allocate_resources()
         bail_out(EXIT_FAILURE, "Error closing shared memory file descriptor");
     }
 
-    sem_serv = sem_open(SEM_SERV_NAME, O_CREAT | O_EXCL, PERM, 0);
-
-    if(sem_serv == SEM_FAILED) {
-        bail_out(EXIT_FAILURE, "Error creating semaphore %s", SEM_SERV_NAME);
-    }
-
-    sem_client = sem_open(SEM_CLIENT_NAME, O_CREAT | O_EXCL, PERM, 1);
-    
-    if(sem_client == SEM_FAILED) {
-        bail_out(EXIT_FAILURE, "Error creating semaphore %s", SEM_SERV_NAME);
-    }
-
-    sem_comm = sem_open(SEM_COMM_NAME, O_CREAT | O_EXCL, PERM , 0);
-
-    if(sem_comm == SEM_FAILED) {
-        bail_out(EXIT_FAILURE, "Error creating semaphore %s", SEM_COMM_NAME);
+    /* the object is new, so everything else, the doorbells included, starts out zero */
+    if(sem_init(&shm->connect_lock, 1, 1) == -1) {
+        bail_out(EXIT_FAILURE, "Error creating semaphore");
     }
-    shared->terminate = 0;
-}
-
-static void add_word(char *word)
-{
-    char **tmp = (char**)realloc(word_list, (words+1)*sizeof(char*));
-    if(tmp == NULL) {
-        bail_out(EXIT_FAILURE, "Error extending word list");
+    for(int i=0; i<worker_count; i++) {
+        ring_init(&shm->rings[i]);
     }
-    word_list = tmp;
-    word_list[words] = word; 
-    words++;
+    shm->workers = worker_count;
+    shm->terminate = 0;
 }
 
 static void free_word_list()
 {
-    for(int i=0; i<words; i++) {
-        if(word_list[i] != NULL) {
-            free(word_list[i]);
-        }
-    }
-    free(word_list);
+    dict_free(&dict);
     words = 0;
 }
 
 static void free_client_list() 
 {
-    for(int i=0; i<connected_clients; i++) {
-        if(client_list[i] != NULL) {
-            free(client_list[i]);
-        }
-    }
-    free(client_list);
-    connected_clients = 0;
+    free(client_table);
+    client_table = NULL;
+    free(workers);
+    workers = NULL;
 }
 
 static void handle_signal(int signal)
@@ -550,57 +594,48 @@ static void handle_signal(int signal)
     want_quit = 1;
 }
 
-static void prepare_mem(client *c)
+static void prepare_mem(struct comm *shared, client *c)
 {
     shared->mistakes = c->mistakes;
     shared->wins = c->wins;
     shared->losses = c->losses;
-    for(int i=0; i<26; i++) {
-        shared->guessed_letters[i] = c->guessed_letters[i];
-    }
-
+    shared->guessed = c->guessed;
 }
 
-static int valid(char guess, client *c)
+static int play(struct comm *shared, client *c, char letter)
 {
-    for(int i=0; i<WORD_LENGTH; i++) {
-        if(c->current_word[i] == '\0')
-            break;
-        if(c->current_word[i] == guess) {
-            return 1;
+    char guess = (char)toupper((unsigned char)letter);
+    uint32_t bit = LETTER_BIT(guess);
+
+    if(c->word_mask & bit) {
+        if((c->guessed & bit) == 0) {
+            reveal(shared, c, guess);
         }
+        c->guessed |= bit;
+        if((c->word_mask & ~c->guessed) == 0) {
+            shared->rtype = WON;
+            c->wins++;
+        }
+        return 1;
     }
+    if(c->mistakes == 8) {
+        shared->rtype = LOST;     
+        c->losses++;
+    }
+    c->mistakes++;
+    c->guessed |= bit;
     return 0;
 }
 
-static int contains(char letter, char *arr)
+static void reveal(struct comm *shared, client *c, char letter)
 {
+    uint64_t revealed = shared->revealed;
 
-    if(arr[letter-'A'] == 1) {
-        return 1;
-    }
-    return 0;  
-}
-
-static int reveal(char *cword, char *letters)
-{
-    int won = 1;
-    for(int i=0; i<WORD_LENGTH; i++) {
-        if(cword[i] == '\0') {
-            break;
-        }
-        if(contains(cword[i], letters)) {
-            shared->word[i] = cword[i]; 
-        }
-        else {
-            if(cword[i] == ' ') {
-                shared->word[i] = ' ';
-            }
-            else {
-                won = 0;
-                shared->word[i] = '_';
-            }
+    for(int i=0; c->current_word[i] != '\0'; i++) {
+        if(c->current_word[i] == letter) {
+            shared->word[i] = letter;
+            revealed |= (uint64_t)1 << i;
         }
     }
-    return won;
+    shared->revealed = revealed;
 }